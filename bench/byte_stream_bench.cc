@@ -0,0 +1,98 @@
+#include "byte_stream.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// ByteStream 吞吐量基准测试：以固定的写入/读出粒度反复写入并读出，统计每秒搬运的字节数。
+// 另外模拟存储转发中的大量积压：先写入BACKLOG_BYTES再全部读出，对比全部放在内存中与超过阈值后溢出到磁盘，
+// 并给出进程的峰值常驻内存(溢出的情形先运行，峰值不受内存情形的影响)。
+// 每行输出一个结果，格式为"byte_stream key=value ..."，便于不同版本之间逐行对比。
+
+static constexpr size_t CAPACITY = 64000;
+static constexpr size_t TOTAL_BYTES = 1ul << 28;
+
+static double bench_byte_stream(const size_t write_size, const size_t read_size, const bool chunked) {
+    ByteStream stream(CAPACITY, chunked);
+    const string chunk(write_size, 'x');
+    size_t sink = 0;
+
+    const auto start = steady_clock::now();
+    while (stream.bytes_read() < TOTAL_BYTES) {
+        // 写满(或写够一次读出的量)后再读，使两种粒度不同时仍能交替推进
+        while (stream.buffer_size() < read_size && stream.remaining_capacity() > 0) {
+            stream.write(chunk);
+        }
+        sink += stream.read(read_size).size();
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    if (sink != stream.bytes_read()) {
+        throw runtime_error("ByteStream lost bytes");
+    }
+    return stream.bytes_read() / elapsed;
+}
+
+static constexpr size_t BACKLOG_BYTES = 1ul << 28;
+static constexpr size_t SPILL_THRESHOLD = 1ul << 24;
+
+static double bench_backlog(const bool spill) {
+    ByteStream stream(BACKLOG_BYTES);
+    if (spill) {
+        const char *directory = getenv("TMPDIR");
+        stream.enable_spill(directory != nullptr ? directory : "/tmp", SPILL_THRESHOLD);
+    }
+    const string chunk(1 << 16, 'x');
+    size_t sink = 0;
+
+    const auto start = steady_clock::now();
+    for (int round = 0; round < 2; ++round) {
+        while (stream.remaining_capacity() > 0) {
+            stream.write(chunk);
+        }
+        while (!stream.buffer_empty()) {
+            sink += stream.read(16384).size();
+        }
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    if (sink != stream.bytes_read()) {
+        throw runtime_error("ByteStream lost bytes");
+    }
+    return stream.bytes_read() / elapsed;
+}
+
+int main() {
+    try {
+        for (const bool spill : {true, false}) {
+            const double throughput = bench_backlog(spill);
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            cout << "byte_stream mode=backlog storage=" << (spill ? "spill" : "memory") << " backlog=" << BACKLOG_BYTES
+                 << " bytes/sec=" << static_cast<uint64_t>(throughput) << " max_rss_kb=" << usage.ru_maxrss << "\n";
+        }
+        for (const bool chunked : {false, true}) {
+            for (const size_t write_size : {1ul, 16ul, 256ul, 1000ul, 4096ul, 16384ul}) {
+                for (const size_t read_size : {1ul, 1000ul, 16384ul}) {
+                    // 逐字节写入分片模式的流没有实际意义，只会测到Buffer的分配开销
+                    if (chunked && write_size < 256) {
+                        continue;
+                    }
+                    cout << "byte_stream mode=" << (chunked ? "chunked" : "ring") << " write=" << write_size
+                         << " read=" << read_size << " bytes/sec="
+                         << static_cast<uint64_t>(bench_byte_stream(write_size, read_size, chunked)) << "\n";
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
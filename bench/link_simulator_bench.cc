@@ -0,0 +1,159 @@
+#include "congestion_controller.hh"
+#include "link_simulator.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// 端到端传输基准测试：在模拟的有损链路上用TCPSender向TCPReceiver传输固定大小的数据，
+// 对比不同的链路条件与发送方配置。虚拟时间驱动，相同的种子总会得到相同的结果。
+// 每行输出一个结果，格式为"link_simulator key=value ..."，便于不同版本之间逐行对比。
+
+static constexpr size_t TRANSFER_BYTES = 10'000'000;
+static constexpr size_t SENDER_CAPACITY = 1 << 20;
+static constexpr size_t RECEIVER_CAPACITY = 1 << 20;
+
+struct Scenario {
+    string name;
+    LinkConfig forward;
+    LinkConfig reverse;
+};
+
+struct Variant {
+    string name;
+    function<void(TCPSender &)> configure;
+    bool sack;
+};
+
+static pair<TransferReport, TCPStatsSnapshot> run_transfer(const Scenario &scenario, const Variant &variant) {
+    TCPSender sender(SENDER_CAPACITY, TCPConfig::TIMEOUT_DFLT, WrappingInt32{0});
+    TCPReceiver receiver(RECEIVER_CAPACITY);
+    sender.set_peer_window_shift(receiver.window_shift());
+    receiver.set_window_scaling(true);
+    auto stats = make_shared<TCPStats>();
+    sender.set_stats(stats);
+    receiver.set_stats(stats);
+    variant.configure(sender);
+
+    LinkSimulator simulator(sender, receiver, scenario.forward, scenario.reverse);
+    simulator.enable_sack(variant.sack);
+    const TransferReport report = simulator.run(TRANSFER_BYTES);
+    return {report, stats->snapshot()};
+}
+
+int main() {
+    try {
+        // 100Mbit/s、单向20ms的链路，瓶颈队列约为一个BDP
+        LinkConfig clean;
+        clean.bandwidth_bps = 100'000'000;
+        clean.delay_ms = 20;
+        clean.queue_bytes = 500'000;
+
+        LinkConfig ack_path = clean;
+        ack_path.queue_bytes = 0;
+
+        LinkConfig random_loss = clean;
+        random_loss.loss_rate = 0.01;
+
+        LinkConfig bursty_loss = clean;
+        bursty_loss.burst_enter_rate = 0.002;
+        bursty_loss.burst_exit_rate = 0.25;
+
+        LinkConfig reordering = clean;
+        reordering.reorder_rate = 0.05;
+        reordering.reorder_delay_ms = 3;
+
+        LinkConfig duplication = clean;
+        duplication.duplicate_rate = 0.02;
+
+        LinkConfig shallow_queue = clean;
+        shallow_queue.queue_bytes = 32'000;
+
+        const Scenario scenarios[] = {{"clean", clean, ack_path},
+                                      {"random_loss", random_loss, ack_path},
+                                      {"bursty_loss", bursty_loss, ack_path},
+                                      {"reordering", reordering, ack_path},
+                                      {"duplication", duplication, ack_path},
+                                      {"shallow_queue", shallow_queue, ack_path}};
+
+        const Variant variants[] = {
+            {"window_only", [](TCPSender &) {}, false},
+            {"newreno_sack",
+             [](TCPSender &sender) {
+                 sender.set_congestion_controller(make_unique<NewRenoController>());
+                 sender.enable_fast_retransmit();
+                 sender.enable_adaptive_rto();
+             },
+             true},
+            {"cubic_sack",
+             [](TCPSender &sender) {
+                 sender.set_congestion_controller(make_unique<CubicController>());
+                 sender.enable_fast_retransmit();
+                 sender.enable_adaptive_rto();
+             },
+             true},
+            {"bbr_sack",
+             [](TCPSender &sender) {
+                 sender.set_congestion_controller(make_unique<BBRController>());
+                 sender.enable_fast_retransmit();
+                 sender.enable_adaptive_rto();
+             },
+             true},
+            {"newreno_sack_paced",
+             [](TCPSender &sender) {
+                 sender.set_congestion_controller(make_unique<NewRenoController>());
+                 sender.enable_fast_retransmit();
+                 sender.enable_adaptive_rto();
+                 sender.enable_pacing();
+             },
+             true},
+            {"cubic_sack_paced",
+             [](TCPSender &sender) {
+                 sender.set_congestion_controller(make_unique<CubicController>());
+                 sender.enable_fast_retransmit();
+                 sender.enable_adaptive_rto();
+                 sender.enable_pacing();
+             },
+             true},
+            {"bbr_sack_paced",
+             [](TCPSender &sender) {
+                 sender.set_congestion_controller(make_unique<BBRController>());
+                 sender.enable_fast_retransmit();
+                 sender.enable_adaptive_rto();
+                 sender.enable_pacing();
+             },
+             true}};
+
+        for (const auto &scenario : scenarios) {
+            for (const auto &variant : variants) {
+                const auto [report, stats] = run_transfer(scenario, variant);
+                cout << "link_simulator scenario=" << scenario.name << " variant=" << variant.name
+                     << " completed=" << report.completed << " completion_ms=" << report.completion_ms
+                     << " goodput_bps=" << static_cast<uint64_t>(report.goodput_bps)
+                     << " segments_sent=" << report.segments_sent << " retransmissions=" << report.retransmissions
+                     << " rto_retransmissions=" << stats.rto_retransmissions
+                     << " fast_retransmissions=" << stats.fast_retransmissions
+                     << " lost_retransmissions=" << stats.lost_retransmissions
+                     << " duplicate_acks=" << stats.duplicate_acks << " acks_sent=" << report.acks_sent
+                     << " forward_drops=" << report.forward_drops
+                     << " peak_unassembled_bytes=" << stats.peak_unassembled_bytes
+                     << " window_limited_ms=" << stats.window_limited_ms << " app_limited_ms=" << stats.app_limited_ms
+                     << " latency_p50_ms=" << report.latency_p50_ms << " latency_p90_ms=" << report.latency_p90_ms
+                     << " latency_p99_ms=" << report.latency_p99_ms << " latency_max_ms=" << report.latency_max_ms
+                     << "\n";
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "congestion_controller.hh"
+#include "link_simulator.hh"
+#include "reassembly_memory_pool.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// 乱序数据内存池基准测试：一批连接同时在有丢包的模拟链路上传输，每个接收方都会因丢包暂存乱序数据。
+// 对比不设内存池与设置不同的共享上限时，所有连接合计的乱序字节峰值、被修剪的字节数与完成时间。
+// 虚拟时间驱动，结果可完全复现。每行输出一个结果，格式为"reassembly_memory_pool key=value ..."。
+
+static constexpr size_t CONNECTIONS = 64;
+static constexpr size_t TRANSFER_BYTES = 2'000'000;
+static constexpr size_t CAPACITY = 512'000;
+
+struct Connection {
+    TCPSender sender;
+    TCPReceiver receiver;
+    LinkSimulator simulator;
+
+    Connection(const LinkConfig &forward, const LinkConfig &reverse, const uint64_t seed)
+        : sender(CAPACITY, TCPConfig::TIMEOUT_DFLT, WrappingInt32{static_cast<uint32_t>(seed)})
+        , receiver(CAPACITY)
+        , simulator(sender, receiver, forward, reverse, seed) {}
+};
+
+static void bench_pool(const size_t limit) {
+    LinkConfig forward;
+    forward.bandwidth_bps = 20'000'000;
+    forward.delay_ms = 20;
+    forward.loss_rate = 0.02;
+    forward.queue_bytes = 200'000;
+    LinkConfig reverse;
+    reverse.delay_ms = 20;
+
+    shared_ptr<ReassemblyMemoryPool> pool = (limit > 0) ? make_shared<ReassemblyMemoryPool>(limit) : nullptr;
+    deque<Connection> connections;
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        Connection &connection = connections.emplace_back(forward, reverse, i + 1);
+        connection.sender.set_peer_window_shift(connection.receiver.window_shift());
+        connection.receiver.set_window_scaling(true);
+        connection.sender.set_congestion_controller(make_unique<NewRenoController>());
+        connection.sender.enable_fast_retransmit();
+        connection.sender.enable_adaptive_rto();
+        connection.simulator.enable_sack();
+        if (pool) {
+            connection.receiver.attach_memory_pool(pool);
+        }
+        connection.simulator.start(TRANSFER_BYTES);
+    }
+
+    size_t peak_total = 0;
+    size_t running = CONNECTIONS;
+    vector<bool> done(CONNECTIONS, false);
+    while (running > 0) {
+        size_t total = 0;
+        for (size_t i = 0; i < CONNECTIONS; ++i) {
+            if (!done[i] && connections[i].simulator.step()) {
+                done[i] = true;
+                --running;
+            }
+            total += connections[i].receiver.unassembled_bytes();
+        }
+        peak_total = max(peak_total, total);
+    }
+
+    size_t completed = 0;
+    uint64_t completion_sum = 0, completion_max = 0, retransmissions = 0;
+    for (auto &connection : connections) {
+        const TransferReport report = connection.simulator.report();
+        completed += report.completed;
+        completion_sum += report.completion_ms;
+        completion_max = max(completion_max, report.completion_ms);
+        retransmissions += report.retransmissions;
+    }
+    cout << "reassembly_memory_pool limit=" << limit << " connections=" << CONNECTIONS << " completed=" << completed
+         << " peak_ofo_bytes=" << peak_total << " prune_events=" << (pool ? pool->stats().prune_events : 0)
+         << " pruned_bytes=" << (pool ? pool->stats().pruned_bytes : 0) << " retransmissions=" << retransmissions
+         << " completion_avg_ms=" << completion_sum / CONNECTIONS << " completion_max_ms=" << completion_max << "\n";
+}
+
+int main() {
+    try {
+        for (const size_t limit : {size_t{0}, size_t{4'000'000}, size_t{1'000'000}, size_t{250'000}}) {
+            bench_pool(limit);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "congestion_controller.hh"
+#include "link_simulator.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// 接收窗口自动调整基准测试：在100Mbit/s、单向20ms(BDP约500KB)的链路上传输固定大小的数据，
+// 对比固定的小容量、固定的大容量与从小容量开始自动调整的接收方的吞吐量与实际占用的容量，
+// 以及传输结束、空闲一段时间后容量是否回落。链路队列不限长、不丢包，吞吐量只受接收窗口与
+// 应用的读取速率限制：读得快的应用每步读完全部数据，读得慢的应用只能读20Mbit/s。
+// 虚拟时间驱动，结果可完全复现。
+// 每行输出一个结果，格式为"receive_autotuning key=value ..."。
+
+static constexpr size_t TRANSFER_BYTES = 50'000'000;
+static constexpr size_t SENDER_CAPACITY = 8 << 20;
+static constexpr size_t SMALL_CAPACITY = 64 << 10;
+static constexpr size_t LARGE_CAPACITY = 4 << 20;
+static constexpr size_t IDLE_MS = 1000;
+static constexpr size_t SLOW_READ_BYTES_PER_MS = 2'500;
+
+struct Variant {
+    string name;
+    size_t capacity;
+    bool autotuning;
+};
+
+static void run_transfer(const Variant &variant, const bool slow_reader) {
+    TCPSender sender(SENDER_CAPACITY, TCPConfig::TIMEOUT_DFLT, WrappingInt32{0});
+    TCPReceiver receiver(variant.capacity);
+    if (variant.autotuning) {
+        receiver.enable_autotuning(LARGE_CAPACITY, IDLE_MS);
+    }
+    sender.set_peer_window_shift(receiver.window_shift());
+    receiver.set_window_scaling(true);
+    sender.set_congestion_controller(make_unique<NewRenoController>());
+    sender.enable_fast_retransmit();
+    sender.enable_adaptive_rto();
+
+    LinkConfig forward;
+    forward.bandwidth_bps = 100'000'000;
+    forward.delay_ms = 20;
+    LinkConfig reverse = forward;
+
+    LinkSimulator simulator(sender, receiver, forward, reverse);
+    simulator.enable_sack();
+    simulator.set_read_rate(slow_reader ? SLOW_READ_BYTES_PER_MS : 0);
+    simulator.start(TRANSFER_BYTES);
+    size_t peak_capacity = receiver.capacity();
+    size_t peak_buffered = 0;
+    while (!simulator.step()) {
+        peak_capacity = max(peak_capacity, receiver.capacity());
+        peak_buffered = max(peak_buffered, receiver.stream_out().buffer_size() + receiver.unassembled_bytes());
+    }
+    const TransferReport report = simulator.report();
+    const size_t final_capacity = receiver.capacity();
+
+    // 传输结束后连接保持空闲
+    for (size_t ms = 0; ms <= IDLE_MS; ++ms) {
+        receiver.tick(1);
+    }
+
+    cout << "receive_autotuning reader=" << (slow_reader ? "slow" : "fast") << " variant=" << variant.name
+         << " completed=" << report.completed
+         << " completion_ms=" << report.completion_ms << " goodput_bps=" << static_cast<uint64_t>(report.goodput_bps)
+         << " peak_capacity=" << peak_capacity << " peak_buffered=" << peak_buffered
+         << " final_capacity=" << final_capacity
+         << " idle_capacity=" << receiver.capacity() << " latency_p99_ms=" << report.latency_p99_ms << "\n";
+}
+
+int main() {
+    try {
+        const Variant variants[] = {{"fixed_64k", SMALL_CAPACITY, false},
+                                    {"fixed_4m", LARGE_CAPACITY, false},
+                                    {"autotune_64k_4m", SMALL_CAPACITY, true}};
+        for (const bool slow_reader : {false, true}) {
+            for (const auto &variant : variants) {
+                run_transfer(variant, slow_reader);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "congestion_controller.hh"
+#include "sharded_engine.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+// 分片引擎的扩展性基准测试：同一批模拟链路上的连接分别交给1、2、4...个shard处理，
+// 统计墙上时间、每秒完成的连接数以及相对单个shard的加速比。
+// 每行输出一个结果，格式为"sharded_engine key=value ..."，便于不同版本之间逐行对比。
+
+static constexpr size_t CONNECTIONS = 512;
+static constexpr size_t TRANSFER_BYTES = 1'000'000;
+
+static double bench_engine(const size_t shards, size_t &completed) {
+    EngineConfig config;
+    config.sender_capacity = 256'000;
+    config.receiver_capacity = 256'000;
+    config.configure = [](TCPSender &sender, TCPReceiver &receiver, LinkSimulator &simulator) {
+        sender.set_peer_window_shift(receiver.window_shift());
+        receiver.set_window_scaling(true);
+        sender.set_congestion_controller(make_unique<NewRenoController>());
+        sender.enable_fast_retransmit();
+        sender.enable_adaptive_rto();
+        simulator.enable_sack();
+    };
+
+    // 每条连接有自己的10Mbit/s、单向10ms、0.5%丢包的链路
+    LinkConfig forward;
+    forward.bandwidth_bps = 10'000'000;
+    forward.delay_ms = 10;
+    forward.loss_rate = 0.005;
+    forward.queue_bytes = 64'000;
+    LinkConfig reverse;
+    reverse.delay_ms = 10;
+
+    const auto start = steady_clock::now();
+    ShardedEngine engine(shards, config);
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        ConnectionRequest request;
+        request.tuple = {0x0a000001, 0x0a000002, static_cast<uint16_t>(10000 + i), 80};
+        request.transfer_bytes = TRANSFER_BYTES;
+        request.forward = forward;
+        request.reverse = reverse;
+        request.seed = i + 1;
+        engine.submit(request);
+    }
+    const auto results = engine.finish();
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    completed = count_if(results.begin(), results.end(), [](const ConnectionResult &r) { return r.report.completed; });
+    return elapsed;
+}
+
+int main() {
+    try {
+        const size_t cores = max<size_t>(thread::hardware_concurrency(), 1);
+        double baseline = 0;
+        for (size_t shards = 1; shards <= cores; shards *= 2) {
+            size_t completed = 0;
+            const double elapsed = bench_engine(shards, completed);
+            if (shards == 1) {
+                baseline = elapsed;
+            }
+            cout << "sharded_engine shards=" << shards << " cores=" << cores << " connections=" << CONNECTIONS
+                 << " completed=" << completed << " wall_ms=" << static_cast<uint64_t>(elapsed * 1000)
+                 << " connections/sec=" << static_cast<uint64_t>(CONNECTIONS / elapsed)
+                 << " speedup=" << baseline / elapsed << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
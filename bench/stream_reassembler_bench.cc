@@ -0,0 +1,75 @@
+#include "stream_reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// StreamReassembler 后端对比：以一个窗口为单位，把窗口内的片段按不同顺序推入，统计每秒重组的字节数。
+// 每行输出一个结果，格式为"stream_reassembler key=value ..."，便于不同版本之间逐行对比。
+
+static constexpr size_t CAPACITY = 64000;
+static constexpr size_t SEGMENT_SIZE = 1000;
+static constexpr size_t TOTAL_BYTES = 1ul << 27;
+
+enum class PushOrder { InOrder, Reversed, Random, Overlapping };
+
+// 重叠模式下每个片段的长度与相邻片段起点的间距：每个字节平均被6个片段覆盖
+static constexpr size_t OVERLAP_LENGTH = 3 * SEGMENT_SIZE;
+static constexpr size_t OVERLAP_STRIDE = SEGMENT_SIZE / 2;
+
+static double bench_reassembler(const ReassemblerBackend backend, const PushOrder push_order) {
+    StreamReassembler reassembler(CAPACITY, backend);
+    const string data(OVERLAP_LENGTH, 'x');
+    const size_t stride = (push_order == PushOrder::Overlapping) ? OVERLAP_STRIDE : SEGMENT_SIZE;
+    const size_t length = (push_order == PushOrder::Overlapping) ? OVERLAP_LENGTH : SEGMENT_SIZE;
+    vector<size_t> order(CAPACITY / stride);
+    mt19937 rng(144);
+
+    const auto start = steady_clock::now();
+    while (reassembler.stream_out().bytes_read() < TOTAL_BYTES) {
+        const size_t base = reassembler.stream_out().bytes_read();
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = base + i * stride;
+        }
+        if (push_order == PushOrder::Reversed) {
+            reverse(order.begin(), order.end());
+        }
+        if (push_order == PushOrder::Random || push_order == PushOrder::Overlapping) {
+            shuffle(order.begin(), order.end(), rng);
+        }
+        for (const size_t index : order) {
+            reassembler.push_substring(data.substr(0, min(length, base + CAPACITY - index)), index, false);
+        }
+        reassembler.stream_out().pop_output(CAPACITY);
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    return reassembler.stream_out().bytes_read() / elapsed;
+}
+
+int main() {
+    try {
+        const pair<PushOrder, string> orders[] = {{PushOrder::InOrder, "in_order"},
+                                                  {PushOrder::Reversed, "reversed"},
+                                                  {PushOrder::Random, "random"},
+                                                  {PushOrder::Overlapping, "overlapping"}};
+        for (const auto backend : {ReassemblerBackend::IntervalMap, ReassemblerBackend::Bitmap}) {
+            const string name = (backend == ReassemblerBackend::Bitmap) ? "bitmap" : "interval_map";
+            for (const auto &[push_order, order_name] : orders) {
+                cout << "stream_reassembler backend=" << name << " order=" << order_name << " bytes/sec="
+                     << static_cast<uint64_t>(bench_reassembler(backend, push_order)) << "\n";
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// TCPSender::ack_received 开销随窗口大小变化的基准测试。
+// 发送方先填满对端窗口，再逐个segment地确认：
+//   cumulative: 每个ACK累积确认队首的一个segment，整个窗口确认完后再重新填满
+//   sack:       队首segment"丢失"，其余segment逐个被SACK，最后一次性累积确认整个窗口
+// 另外测量发送路径的开销(写入、fill_window、取出segment、逐个确认)，平摊到每个segment：
+//   ring:    应用写入的数据被复制进环形缓冲区，每个segment的负载从中读出
+//   chunked: 应用按MSS写入Buffer，segment直接共享其存储
+// 每行输出一个结果，格式为"tcp_sender key=value ..."，便于不同版本之间逐行对比。
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr size_t TOTAL_ACKS = 1ul << 18;
+
+// 选择最小的窗口缩放因子，使window >> shift能放进16位窗口字段
+static uint8_t window_shift_for(const size_t window) {
+    uint8_t shift = 0;
+    while ((window >> shift) > numeric_limits<uint16_t>::max()) {
+        ++shift;
+    }
+    return shift;
+}
+
+static void drain(TCPSender &sender) {
+    while (!sender.segments_out().empty()) {
+        sender.segments_out().pop();
+    }
+}
+
+static void top_up(TCPSender &sender, const string &data) {
+    sender.stream_in().write(data);
+    sender.fill_window();
+    drain(sender);
+}
+
+static double bench_ack_received(const size_t window, const bool sack) {
+    const WrappingInt32 isn{0};
+    const uint8_t shift = window_shift_for(window);
+    // 向上取整，使缩放后通告的窗口不小于window
+    const auto window_field = static_cast<uint16_t>((window + (1ul << shift) - 1) >> shift);
+    const string data(window, 'x');
+
+    TCPSender sender(2 * window, TCPConfig::TIMEOUT_DFLT, isn);
+    sender.set_peer_window_shift(shift);
+    sender.fill_window();
+    drain(sender);
+    sender.ack_received(wrap(1, isn), window_field);
+    top_up(sender, data);
+
+    size_t acks = 0;
+    duration<double> elapsed{0};
+    while (acks < TOTAL_ACKS) {
+        const uint64_t base = sender.next_seqno_absolute() - sender.bytes_in_flight();
+        const auto start = steady_clock::now();
+        if (sack) {
+            // 队首留下一个空洞，SACK块的右边界逐段推进
+            for (uint64_t right = base + 2 * MSS; right <= base + window; right += MSS) {
+                sender.ack_received(wrap(base, isn), window_field, {{wrap(base + MSS, isn), wrap(right, isn)}});
+                ++acks;
+            }
+            sender.ack_received(wrap(base + window, isn), window_field);
+            ++acks;
+        } else {
+            for (uint64_t ackno = base + MSS; ackno <= base + window; ackno += MSS) {
+                sender.ack_received(wrap(ackno, isn), window_field);
+                ++acks;
+            }
+        }
+        elapsed += steady_clock::now() - start;
+        top_up(sender, data);
+    }
+    return elapsed.count() * 1e9 / acks;
+}
+
+static double bench_send_path(const size_t window, const bool chunked) {
+    const WrappingInt32 isn{0};
+    const uint8_t shift = window_shift_for(window);
+    const auto window_field = static_cast<uint16_t>((window + (1ul << shift) - 1) >> shift);
+    const string data(window, 'x');
+    const Buffer chunk(string(MSS, 'x'));
+
+    TCPSender sender(2 * window, TCPConfig::TIMEOUT_DFLT, isn, chunked);
+    sender.set_peer_window_shift(shift);
+    sender.fill_window();
+    drain(sender);
+    sender.ack_received(wrap(1, isn), window_field);
+
+    size_t segments = 0;
+    const auto start = steady_clock::now();
+    while (segments < TOTAL_ACKS) {
+        if (chunked) {
+            for (size_t written = 0; written < window; written += MSS) {
+                sender.stream_in().write(chunk);
+            }
+        } else {
+            sender.stream_in().write(data);
+        }
+        sender.fill_window();
+        while (!sender.segments_out().empty()) {
+            sender.segments_out().pop();
+            ++segments;
+        }
+        const uint64_t base = sender.next_seqno_absolute() - sender.bytes_in_flight();
+        for (uint64_t ackno = base + MSS; ackno <= base + window; ackno += MSS) {
+            sender.ack_received(wrap(ackno, isn), window_field);
+        }
+    }
+    return duration<double>(steady_clock::now() - start).count() * 1e9 / segments;
+}
+
+int main() {
+    try {
+        for (const bool chunked : {false, true}) {
+            for (const size_t requested : {16000ul, 256000ul}) {
+                const size_t window = requested / MSS * MSS;
+                cout << "tcp_sender mode=send stream=" << (chunked ? "chunked" : "ring") << " window=" << window
+                     << " ns/segment=" << bench_send_path(window, chunked) << "\n";
+            }
+        }
+        for (const bool sack : {false, true}) {
+            for (const size_t requested : {16000ul, 64000ul, 256000ul, 1000000ul, 4000000ul}) {
+                // 窗口取MSS的整数倍，保证每个ACK都恰好落在segment边界上
+                const size_t window = requested / MSS * MSS;
+                cout << "tcp_sender mode=" << (sack ? "sack" : "cumulative") << " window=" << window
+                     << " ns/ack=" << bench_ack_received(window, sack) << "\n";
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// wrap/unwrap 吞吐量基准测试：对预先生成的随机序号反复转换，统计每秒完成的转换次数。
+// 每行输出一个结果，格式为"wrapping_integers key=value ..."，便于不同版本之间逐行对比。
+
+static constexpr size_t SAMPLES = 1ul << 16;
+static constexpr size_t ROUNDS = 1ul << 10;
+
+int main() {
+    try {
+        mt19937_64 rng(144);
+        const WrappingInt32 isn{static_cast<uint32_t>(rng())};
+        vector<uint64_t> absolute(SAMPLES);
+        vector<uint64_t> checkpoints(SAMPLES);
+        vector<WrappingInt32> relative;
+        relative.reserve(SAMPLES);
+        for (size_t i = 0; i < SAMPLES; ++i) {
+            // 检查点落在真实序号附近，与TCP中用已确认序号作检查点的情形一致
+            absolute[i] = (rng() >> 1) + (1ul << 30);
+            checkpoints[i] = absolute[i] + (rng() % (1ul << 30)) - (1ul << 29);
+            relative.push_back(wrap(absolute[i], isn));
+        }
+
+        // 累加转换结果，防止编译器把循环整个优化掉
+        uint64_t sink = 0;
+        auto start = steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            for (size_t i = 0; i < SAMPLES; ++i) {
+                sink += wrap(absolute[i] + round, isn).raw_value();
+            }
+        }
+        auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        cout << "wrapping_integers op=wrap ops/sec=" << static_cast<uint64_t>(SAMPLES * ROUNDS / elapsed) << "\n";
+
+        start = steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            for (size_t i = 0; i < SAMPLES; ++i) {
+                sink += unwrap(relative[i], isn, checkpoints[i] + round);
+            }
+        }
+        elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        cout << "wrapping_integers op=unwrap ops/sec=" << static_cast<uint64_t>(SAMPLES * ROUNDS / elapsed) << "\n";
+
+        // 校验unwrap确实还原了原序号，顺带让sink保持存活
+        for (size_t i = 0; i < SAMPLES; ++i) {
+            if (unwrap(relative[i], isn, checkpoints[i]) != absolute[i]) {
+                throw runtime_error("unwrap returned the wrong absolute seqno");
+            }
+        }
+        cerr << "checksum=" << sink << "\n";
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,7 @@
 #include "byte_stream.hh"
 
+#include <stdexcept>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,29 +14,190 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : _capacity(capacity) { }
+//! \details 环形缓冲区的长度为2的幂，这样读写位置只需用累计字节数与掩码相与即可得到；
+//! 缓冲区按需倍增，容量为数MB的流在只缓存少量数据时不会占用全部内存。
+//! 分块模式下不分配环形缓冲区
+ByteStream::ByteStream(const size_t capacity, const bool chunked) : _capacity(capacity), _chunked(chunked) {
+    if (_chunked) {
+        return;
+    }
+    size_t ring_size = 1;
+    while (ring_size < min(capacity, INITIAL_RING_SIZE)) {
+        ring_size <<= 1;
+    }
+    _buffer.resize(ring_size);
+    _mask = ring_size - 1;
+}
+
+//! \details 原子计数器不能移动，逐个读出后写入；被移动的流恢复为空流，仍可继续使用
+ByteStream::ByteStream(ByteStream &&other) { *this = move(other); }
+
+ByteStream &ByteStream::operator=(ByteStream &&other) {
+    if (this == &other) {
+        return *this;
+    }
+    if (_waiter || other._waiter) {
+        throw runtime_error("ByteStream: a concurrent stream cannot be moved");
+    }
+    _error.store(other._error.exchange(false, memory_order_relaxed), memory_order_relaxed);
+    _buffer = move(other._buffer);
+    _mask = exchange(other._mask, 0);
+    _capacity = other._capacity;
+    _bytes_written.store(other._bytes_written.exchange(0, memory_order_relaxed), memory_order_relaxed);
+    _ended.store(other._ended.exchange(false, memory_order_relaxed), memory_order_relaxed);
+    _bytes_read.store(other._bytes_read.exchange(0, memory_order_relaxed), memory_order_relaxed);
+    _chunked = other._chunked;
+    _chunks = move(other._chunks);
+    _spill = move(other._spill);
+    _memory_threshold = other._memory_threshold;
+    other._buffer.clear();
+    other._chunks.clear();
+    return *this;
+}
+
+//! \details 新缓冲区长度为不小于needed的2的幂；未读的字节按新的掩码重新放置，
+//! 由于它们的跨度不超过新缓冲区长度，重新放置后仍然最多分为两段
+void ByteStream::resize_ring(const size_t needed) {
+    size_t ring_size = 1;
+    while (ring_size < needed) {
+        ring_size <<= 1;
+    }
+    vector<char> ring(ring_size);
+    size_t new_mask = ring_size - 1;
+    auto views = peek_views(memory_size());
+    size_t head = _bytes_read.load(memory_order_relaxed) & new_mask;
+    for (const string_view view : {views.first, views.second}) {
+        size_t first_len = min(view.size(), ring_size - head);
+        view.copy(ring.data() + head, first_len);
+        view.copy(ring.data(), view.size() - first_len, first_len);
+        head = (head + view.size()) & new_mask;
+    }
+    _buffer.swap(ring);
+    _mask = new_mask;
+}
 
 size_t ByteStream::write(const string &data) {
-    if (_ended) {
+    if (_chunked) {
+        return write(string(data.substr(0, remaining_capacity())));
+    }
+    return write_to_ring(data);
+}
+
+size_t ByteStream::write(const string_view data) {
+    if (_chunked) {
+        return write(string(data.substr(0, remaining_capacity())));
+    }
+    return write_to_ring(data);
+}
+
+size_t ByteStream::write(string &&data) {
+    if (!_chunked) {
+        return write_to_ring(data);
+    }
+    data.resize(min(data.length(), remaining_capacity()));  // 超出容量的部分直接截断，不产生拷贝
+    return write(Buffer(move(data)));
+}
+
+size_t ByteStream::write(Buffer data) {
+    if (!_chunked) {
+        return write_to_ring(data.str());
+    }
+    if (_ended.load(memory_order_relaxed) || data.size() == 0) {
+        return 0;
+    }
+    /* Buffer只能去除前缀，因此超出容量时只能拷贝出可写入的部分 */
+    if (data.size() > remaining_capacity()) {
+        data = Buffer(string(data.str().substr(0, remaining_capacity())));
+    }
+    size_t write_len = data.size();
+    if (write_len > 0) {
+        _chunks.push_back(move(data));
+    }
+    _bytes_written.store(_bytes_written.load(memory_order_relaxed) + write_len, memory_order_release);
+    return write_len;
+}
+
+//! \details 开启溢出时，只有_spill为空才能写入环形缓冲区(保持字节顺序)，且缓冲区中不超过内存阈值；
+//! 写入环形缓冲区时尚未读出的字节都在环形缓冲区中，因此累计字节数可以直接作为环形缓冲区中的位置
+size_t ByteStream::write_to_ring(const string_view data) {
+    if (_ended.load(memory_order_relaxed)) {
         return 0;
     }
     size_t write_len = min(data.length(), remaining_capacity());
-    _buffer.insert(_buffer.cend(), data.cbegin(), data.cbegin()+write_len);
-    _bytes_written += write_len;
+    size_t ring_len = write_len;
+    if (_spill) {
+        bool fits_in_memory = _spill->empty() && (buffer_size() < _memory_threshold);
+        ring_len = fits_in_memory ? min(write_len, _memory_threshold - buffer_size()) : 0;
+    }
+    if (memory_size() + ring_len > _buffer.size()) {
+        resize_ring(memory_size() + ring_len);
+    }
+    /* 分两段拷贝：写位置到缓冲区末尾，以及回绕后缓冲区的开头 */
+    size_t tail = _bytes_written.load(memory_order_relaxed) & _mask;
+    size_t first_len = min(ring_len, _buffer.size() - tail);
+    data.copy(_buffer.data() + tail, first_len);
+    data.copy(_buffer.data(), ring_len - first_len, first_len);
+    if (ring_len < write_len) {
+        _spill->write(data.substr(ring_len, write_len - ring_len));
+    }
+    _bytes_written.store(_bytes_written.load(memory_order_relaxed) + write_len, memory_order_release);
+    notify();
     return write_len;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    size_t peek_len = min(buffer_size(), len);
-    return string(_buffer.cbegin(), _buffer.cbegin()+peek_len);
+    if (_chunked) {
+        string peek_string;
+        peek_string.reserve(min(buffer_size(), len));
+        for (auto it = _chunks.cbegin(); it != _chunks.cend() && peek_string.size() < len; ++it) {
+            peek_string.append(it->str().substr(0, len - peek_string.size()));
+        }
+        return peek_string;
+    }
+    auto views = peek_views(min(len, memory_size()));
+    string peek_string;
+    peek_string.reserve(min(buffer_size(), len));
+    peek_string.append(views.first).append(views.second);
+    if (_spill && peek_string.size() < len) {
+        _spill->append_to(peek_string, len - peek_string.size());
+    }
+    return peek_string;
+}
+
+//! \param[in] len bytes will be exposed from the output side of the buffer
+pair<string_view, string_view> ByteStream::peek_views(const size_t len) const {
+    if (_chunked) {
+        string_view first = _chunks.size() > 0 ? _chunks[0].str().substr(0, len) : string_view();
+        string_view second = _chunks.size() > 1 ? _chunks[1].str().substr(0, len - first.size()) : string_view();
+        return {first, second};
+    }
+    size_t peek_len = min(memory_size(), len);
+    if (peek_len == 0 && _spill) {
+        return _spill->peek_views(len);
+    }
+    size_t head = _bytes_read.load(memory_order_relaxed) & _mask;
+    size_t first_len = min(peek_len, _buffer.size() - head);
+    return {string_view(_buffer.data() + head, first_len), string_view(_buffer.data(), peek_len - first_len)};
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
-void ByteStream::pop_output(const size_t len) { 
+void ByteStream::pop_output(const size_t len) {
     size_t pop_len = min(buffer_size(), len);
-    _bytes_read += pop_len;
-    _buffer.erase(_buffer.cbegin(), _buffer.cbegin()+pop_len);
+    if (_spill && pop_len > memory_size()) {
+        _spill->pop(pop_len - memory_size());
+    }
+    _bytes_read.store(_bytes_read.load(memory_order_relaxed) + pop_len, memory_order_release);
+    notify();
+    /* 分块模式下逐块丢弃，最后一块只去除前缀 */
+    while (_chunked && pop_len > 0) {
+        if (_chunks.front().size() > pop_len) {
+            _chunks.front().remove_prefix(pop_len);
+            break;
+        }
+        pop_len -= _chunks.front().size();
+        _chunks.pop_front();
+    }
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
@@ -42,22 +205,111 @@ void ByteStream::pop_output(const size_t len) {
 //! \returns a string
 std::string ByteStream::read(const size_t len) {
     string read_string = peek_output(len);
-    pop_output(len);
+    pop_output(read_string.size()); // 并发模式下写者可能在两次调用之间追加数据，只弹出已读出的部分
     return read_string;
 }
 
-void ByteStream::end_input() { _ended = true; }
+//! \param[in] len bytes will be popped and returned
+//! \returns a Buffer, sharing storage with the written chunk when it fits within `len`
+Buffer ByteStream::read_buffer(const size_t len) {
+    if (len == 0 || buffer_empty()) {
+        return {};  // 没有数据可读时不分配空的存储
+    }
+    if (_chunked && !_chunks.empty() && _chunks.front().size() <= len) {
+        Buffer chunk = move(_chunks.front());
+        _chunks.pop_front();
+        _bytes_read.store(_bytes_read.load(memory_order_relaxed) + chunk.size(), memory_order_release);
+        return chunk;
+    }
+    return Buffer(read(len));
+}
+
+void ByteStream::end_input() {
+    _ended.store(true, memory_order_release);
+    notify();
+}
+
+bool ByteStream::input_ended() const { return _ended.load(memory_order_acquire); }
+
+//! \details 先读取读出计数，保证在另一线程同时写入时结果不会下溢
+size_t ByteStream::buffer_size() const {
+    size_t bytes_read = _bytes_read.load(memory_order_acquire);
+    return _bytes_written.load(memory_order_acquire) - bytes_read;
+}
+
+bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
 
-bool ByteStream::input_ended() const { return _ended; }
+//! \details 先检查输入结束标志：观察到结束时，结束前写入的全部数据也已可见
+bool ByteStream::eof() const { return input_ended() && buffer_empty(); }
 
-size_t ByteStream::buffer_size() const { return _buffer.size(); }
+size_t ByteStream::bytes_written() const { return _bytes_written.load(memory_order_acquire); }
 
-bool ByteStream::buffer_empty() const { return _buffer.empty(); }
+size_t ByteStream::bytes_read() const { return _bytes_read.load(memory_order_acquire); }
 
-bool ByteStream::eof() const { return _buffer.empty() && _ended; }
+size_t ByteStream::remaining_capacity() const { return _capacity - buffer_size(); }
 
-size_t ByteStream::bytes_written() const { return _bytes_written; }
+//! \details 容量减小时环形缓冲区缩小到恰好容纳已缓存的数据(不小于初始长度)，空闲的流因此只占用很少的内存
+size_t ByteStream::set_capacity(const size_t capacity) {
+    if (_waiter) {
+        return _capacity;
+    }
+    size_t old_capacity = _capacity;
+    _capacity = max(capacity, buffer_size());
+    if (!_chunked && _capacity < old_capacity) {
+        size_t needed = max(memory_size(), min(_capacity, INITIAL_RING_SIZE));
+        if (needed <= _buffer.size() / 2) {
+            resize_ring(needed);
+        }
+    }
+    return _capacity;
+}
 
-size_t ByteStream::bytes_read() const { return _bytes_read; }
+void ByteStream::make_concurrent() {
+    if (_chunked || _waiter || _spill) {
+        return;
+    }
+    resize_ring(max<size_t>(_capacity, 1));
+    _waiter = make_unique<Waiter>();
+}
 
-size_t ByteStream::remaining_capacity() const { return _capacity - _buffer.size(); }
+//! \details 已经在内存中的数据保持不动，之后写入的数据在缓存量超过阈值时开始溢出
+void ByteStream::enable_spill(const string &directory, const size_t memory_threshold, const size_t segment_size) {
+    if (_chunked || _waiter || _spill) {
+        return;
+    }
+    _spill = make_unique<SpillRing>(directory, segment_size);
+    _memory_threshold = memory_threshold;
+}
+
+//! \details 读写计数的更新与等待者计数的读取之间需要一次完整的内存屏障，
+//! 与等待方"先登记再检查条件"配合，保证不会丢失唤醒
+void ByteStream::notify() {
+    if (!_waiter) {
+        return;
+    }
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_waiter->waiting.load(memory_order_relaxed) > 0) {
+        lock_guard<mutex> lock(_waiter->mutex);
+        _waiter->cv.notify_all();
+    }
+}
+
+void ByteStream::wait_readable() {
+    if (!_waiter) {
+        return;
+    }
+    _waiter->waiting.fetch_add(1);
+    unique_lock<mutex> lock(_waiter->mutex);
+    _waiter->cv.wait(lock, [this]() { return !buffer_empty() || input_ended() || error(); });
+    _waiter->waiting.fetch_sub(1);
+}
+
+void ByteStream::wait_writable() {
+    if (!_waiter) {
+        return;
+    }
+    _waiter->waiting.fetch_add(1);
+    unique_lock<mutex> lock(_waiter->mutex);
+    _waiter->cv.wait(lock, [this]() { return remaining_capacity() > 0 || error(); });
+    _waiter->waiting.fetch_sub(1);
+}
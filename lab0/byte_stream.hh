@@ -1,8 +1,18 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
-#include <string>
+#include "buffer.hh"
+#include "spill_ring.hh"
+
+#include <atomic>
+#include <condition_variable>
 #include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief An in-order byte stream.
 
@@ -18,16 +28,62 @@ class ByteStream {
     // that's a sign that you probably want to keep exploring
     // different approaches.
 
-    bool _error{};  //!< Flag indicating that the stream suffered an error.
-    bool _ended{};
-    std::deque<char> _buffer{};
+    // 读写双方各自修改的计数器放在不同的缓存行中，避免跨线程使用时的伪共享
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::atomic<bool> _error{};  //!< Flag indicating that the stream suffered an error.
+    // 环形缓冲区，长度为2的幂，读写位置由累计读写字节数与_mask相与得到
+    std::vector<char> _buffer{};
+    size_t _mask{};
     size_t _capacity{};
-    size_t _bytes_read{};
-    size_t _bytes_written{};
+    // 写入方修改：累计写入字节数(以release发布写入的数据)与输入结束标志
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _bytes_written{0};
+    std::atomic<bool> _ended{};
+    // 读取方修改：累计读出字节数(以release归还缓冲区空间)
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _bytes_read{0};
+    // 分块模式：不使用环形缓冲区，而是直接持有写入方移交的Buffer，读出时按块交出引用计数的Buffer
+    bool _chunked{};
+    std::deque<Buffer> _chunks{};
+
+    // 溢出到磁盘：缓存的字节数超过_memory_threshold后，之后写入的数据进入映射文件，
+    // 流的前一部分在环形缓冲区中，后一部分在_spill中；_spill清空之前新数据都只能追加到_spill
+    std::unique_ptr<SpillRing> _spill{};
+    size_t _memory_threshold{};
+
+    // 环形缓冲区中的字节数
+    size_t memory_size() const { return buffer_size() - (_spill ? _spill->size() : 0); }
+
+    // 将数据拷贝进环形缓冲区(开启溢出时超出内存阈值的部分写入_spill)
+    size_t write_to_ring(const std::string_view data);
+
+    // 环形缓冲区的初始长度，之后按需倍增直至容纳capacity个字节
+    static constexpr size_t INITIAL_RING_SIZE = 1 << 16;
+
+    // 将环形缓冲区的长度调整为不小于needed的最小的2的幂(needed不小于缓存的字节数)
+    void resize_ring(const size_t needed);
+
+    // 跨线程模式下供阻塞等待使用，只有存在等待者时写入/读出才会加锁通知
+    struct Waiter {
+        std::mutex mutex{};
+        std::condition_variable cv{};
+        std::atomic<unsigned int> waiting{0};
+    };
+    std::unique_ptr<Waiter> _waiter{};
+
+    // 唤醒等待者(若有)
+    void notify();
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    //! \param chunked store written buffers as a list of chunks instead of copying them into a ring
+    ByteStream(const size_t capacity, const bool chunked = false);
+
+    //! Move a stream, leaving the moved-from stream empty.
+    //! \note Not available after make_concurrent(), when another thread may be using either stream
+    ByteStream(ByteStream &&other);
+    ByteStream &operator=(ByteStream &&other);
+    ByteStream(const ByteStream &) = delete;
+    ByteStream &operator=(const ByteStream &) = delete;
 
     //! \name "Input" interface for the writer
     //!@{
@@ -37,14 +93,48 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of it
+    //! when the stream is in chunked mode.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a buffer into the stream, sharing its storage when the
+    //! stream is in chunked mode.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
+    //! Write bytes owned by the caller into the stream (copied once,
+    //! straight into the ring in ring mode).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const std::string_view data);
+
+    //! \overload
+    size_t write(const char *data) { return write(std::string_view(data)); }
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! Change the capacity; it never drops below the number of bytes buffered.
+    //! When it drops, the ring shrinks to fit the bytes it holds and grows again as needed.
+    //! \note Not available in concurrent mode, where the ring cannot move: the capacity stays as it is
+    //! \returns the capacity actually applied
+    size_t set_capacity(const size_t capacity);
+
+    //! \returns the current capacity
+    size_t capacity() const { return _capacity; }
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
     //! Indicate that the stream suffered an error.
-    void set_error() { _error = true; }
+    void set_error() {
+        _error = true;
+        notify();
+    }
+
+    //! Block until the stream has room for more bytes, or has suffered an error
+    //! \note only available after make_concurrent(); returns at once otherwise
+    void wait_writable();
     //!@}
 
     //! \name "Output" interface for the reader
@@ -54,6 +144,13 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns up to two contiguous views; the second is empty unless the bytes wrap around
+    //! \note The views are invalidated by the next call to `write` or `pop_output`
+    //! \note In chunked mode the views are the first two chunks, which may cover fewer than `len` bytes;
+    //! likewise once the stream has spilled, they stop at the boundary between memory and the spill file
+    std::pair<std::string_view, std::string_view> peek_views(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -61,6 +158,11 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., hand out and then pop) the next "len" bytes of the stream as a Buffer
+    //! \returns a Buffer; in chunked mode a chunk that fits within `len` is handed out
+    //! whole, sharing its storage instead of copying it
+    Buffer read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -75,6 +177,37 @@ class ByteStream {
 
     //! \returns `true` if the output has reached the ending
     bool eof() const;
+
+    //! Block until the stream has bytes to read, has ended, or has suffered an error
+    //! \note only available after make_concurrent(); returns at once otherwise
+    void wait_readable();
+    //!@}
+
+    //! \name Sharing the stream between a writer thread and a reader thread
+    //!@{
+
+    //! Let one writer thread and one reader thread use the stream concurrently without locks.
+    //! The ring is allocated at full capacity so it never moves, and the wait_* methods can block.
+    //! \note Call before the stream is shared; not available in chunked or spilling mode
+    void make_concurrent();
+    //!@}
+
+    //! \name Spilling very large backlogs to disk
+    //!@{
+
+    //! Keep at most `memory_threshold` buffered bytes in memory; bytes written
+    //! beyond that go to memory-mapped segments of an unlinked temporary file
+    //! in `directory`, and are read back from there in order.
+    //! \note Not available in chunked or concurrent mode
+    void enable_spill(const std::string &directory,
+                      const size_t memory_threshold,
+                      const size_t segment_size = DEFAULT_SPILL_SEGMENT_SIZE);
+
+    //! Default size of one mapped segment of the spill file
+    static constexpr size_t DEFAULT_SPILL_SEGMENT_SIZE = 1 << 24;
+
+    //! \returns the number of buffered bytes currently held in the spill file
+    size_t spilled_bytes() const { return _spill ? _spill->size() : 0; }
     //!@}
 
     //! \name General accounting
@@ -0,0 +1,164 @@
+#include "spill_ring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+//! \details 文件创建后立即unlink，进程退出或环被销毁时磁盘空间自动回收
+SpillRing::SpillRing(const string &directory, const size_t segment_size) : _segment_size(segment_size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    _segment_size = max((segment_size + page_size - 1) / page_size, size_t{1}) * page_size;
+
+    string path = directory + "/bytestream-spill-XXXXXX";
+    _fd = SystemCall("mkstemp", mkstemp(path.data()));
+    SystemCall("unlink", unlink(path.c_str()));
+}
+
+SpillRing::~SpillRing() {
+    for (Segment &segment : _segments) {
+        unmap(segment);
+    }
+    close(_fd);
+}
+
+size_t SpillRing::readable(const size_t index) const {
+    size_t end = (index + 1 == _segments.size()) ? _tail : _segment_size;
+    return end - ((index == 0) ? _head : 0);
+}
+
+//! \details 映射时声明顺序访问，内核因此会加大预读并尽早回收读过的页
+void SpillRing::map(Segment &segment) {
+    if (segment.data != nullptr) {
+        return;
+    }
+    void *data = mmap(nullptr, _segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, segment.file_offset);
+    if (data == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    madvise(data, _segment_size, MADV_SEQUENTIAL);
+    segment.data = static_cast<char *>(data);
+}
+
+void SpillRing::unmap(Segment &segment) {
+    if (segment.data != nullptr) {
+        munmap(segment.data, _segment_size);
+        segment.data = nullptr;
+    }
+}
+
+//! \details 优先复用已读完的文件偏移，否则把文件加长一段
+void SpillRing::add_segment() {
+    size_t offset = _file_size;
+    if (!_free_offsets.empty()) {
+        offset = _free_offsets.back();
+        _free_offsets.pop_back();
+    } else {
+        SystemCall("ftruncate", ftruncate(_fd, _file_size + _segment_size));
+        _file_size += _segment_size;
+    }
+    Segment segment{offset, nullptr};
+    try {
+        map(segment);
+    } catch (const unix_error &) {
+        _free_offsets.push_back(offset);
+        throw;
+    }
+    _segments.push_back(segment);
+    _tail = 0;
+}
+
+//! \details 已读出的数据不再需要写回磁盘：打洞丢弃对应的页与磁盘块(文件系统不支持时忽略)
+void SpillRing::release_front() {
+    Segment &front = _segments.front();
+    unmap(front);
+    fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, front.file_offset, _segment_size);
+    _free_offsets.push_back(front.file_offset);
+    _segments.pop_front();
+    _head = 0;
+}
+
+void SpillRing::prefetch_next() {
+    if (_segments.size() > 1 && _segments[1].data == nullptr) {
+        map(_segments[1]);
+        madvise(_segments[1].data, _segment_size, MADV_WILLNEED);
+    }
+}
+
+//! \details 写满的段立即开始异步写回，使其中的页尽快变为干净页，内存紧张时可以直接回收；
+//! 不在队首两段中的写满的段随即解除映射
+void SpillRing::write(string_view data) {
+    while (!data.empty()) {
+        if (_segments.empty() || _tail == _segment_size) {
+            add_segment();
+            if (_segments.size() > 3) {
+                unmap(_segments[_segments.size() - 2]);
+            }
+        }
+        size_t length = min(data.size(), _segment_size - _tail);
+        data.copy(_segments.back().data + _tail, length);
+        data.remove_prefix(length);
+        _tail += length;
+        _size += length;
+        if (_tail == _segment_size) {
+            sync_file_range(_fd, _segments.back().file_offset, _segment_size, SYNC_FILE_RANGE_WRITE);
+        }
+    }
+}
+
+pair<string_view, string_view> SpillRing::peek_views(const size_t len) const {
+    if (_segments.empty()) {
+        return {};
+    }
+    string_view first(_segments[0].data + _head, min(len, readable(0)));
+    string_view second{};
+    if (_segments.size() > 1) {
+        second = string_view(_segments[1].data, min(len - first.size(), readable(1)));
+    }
+    return {first, second};
+}
+
+//! \details 未映射的段用pread读出，不为一次拷贝建立映射
+void SpillRing::append_to(string &out, const size_t len) const {
+    size_t remaining = min(len, _size);
+    for (size_t i = 0; remaining > 0; ++i) {
+        size_t length = min(remaining, readable(i));
+        size_t offset = (i == 0) ? _head : 0;
+        if (_segments[i].data != nullptr) {
+            out.append(_segments[i].data + offset, length);
+        } else {
+            size_t start = out.size();
+            out.resize(start + length);
+            for (size_t done = 0; done < length;) {
+                size_t file_offset = _segments[i].file_offset + offset + done;
+                done += SystemCall("pread", pread(_fd, &out[start + done], length - done, file_offset));
+            }
+        }
+        remaining -= length;
+    }
+}
+
+//! \details 读完的段立即释放；最后一段读完时整个环清空，下次写入重新映射
+void SpillRing::pop(size_t len) {
+    len = min(len, _size);
+    while (len > 0) {
+        size_t length = min(len, readable(0));
+        _head += length;
+        _size -= length;
+        len -= length;
+        if (readable(0) == 0 && (_segments.size() > 1 || _tail == _segment_size)) {
+            release_front();
+            prefetch_next();
+        }
+    }
+    if (_size == 0) {
+        while (!_segments.empty()) {
+            release_front();
+        }
+        _tail = 0;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef SPONGE_LIBSPONGE_SPILL_RING_HH
+#define SPONGE_LIBSPONGE_SPILL_RING_HH
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//! \brief A FIFO of bytes kept in memory-mapped segments of a temporary file.
+
+//! Used by ByteStream to hold the part of a very large backlog that does
+//! not fit under its memory threshold. The file is unlinked as soon as it
+//! is created, so it disappears when the ring is destroyed.
+class SpillRing {
+  private:
+    // 文件中的一段。只有队首两段(读取方)与队尾段(写入方)保持映射，中间的段写满后即解除映射，
+    // 其中的页由内核写回后即可回收，进程常驻的文件页因此不超过三段
+    struct Segment {
+        size_t file_offset;
+        char *data;  // 未映射时为nullptr
+    };
+
+    int _fd{-1};
+    size_t _segment_size;
+
+    // 按写入顺序排列的段：读取方从队首读，写入方向队尾写
+    std::deque<Segment> _segments{};
+
+    // 已读完、可以复用的文件偏移，文件长度因此不超过同时存在的最大段数
+    std::vector<size_t> _free_offsets{};
+    size_t _file_size{0};
+
+    size_t _head{0};  // 队首段中已读出的字节数
+    size_t _tail{0};  // 队尾段中已写入的字节数
+    size_t _size{0};
+
+    // 第index段中可读的字节数
+    size_t readable(const size_t index) const;
+
+    // 映射/解除映射一段
+    void map(Segment &segment);
+    void unmap(Segment &segment);
+
+    // 在队尾加入一个新段
+    void add_segment();
+
+    // 解除队首段的映射，释放其磁盘空间并回收文件偏移
+    void release_front();
+
+    // 队首段释放后，映射并预读即将被读取的下一段
+    void prefetch_next();
+
+  public:
+    //! Create the backing file in `directory`.
+    //! \param segment_size bytes per mapped segment, rounded up to a whole number of pages
+    SpillRing(const std::string &directory, const size_t segment_size);
+    ~SpillRing();
+    SpillRing(const SpillRing &) = delete;
+    SpillRing &operator=(const SpillRing &) = delete;
+
+    //! Append bytes to the end of the ring
+    void write(std::string_view data);
+
+    //! Peek at up to `len` bytes from the front without copying them
+    //! \returns up to two contiguous views (the first two segments)
+    //! \note The views are invalidated by the next call to `pop`
+    std::pair<std::string_view, std::string_view> peek_views(const size_t len) const;
+
+    //! Append up to `len` bytes from the front to `out`
+    void append_to(std::string &out, const size_t len) const;
+
+    //! Remove bytes from the front, releasing segments that have been read completely
+    void pop(size_t len);
+
+    //! \returns the number of bytes in the ring
+    size_t size() const { return _size; }
+
+    //! \returns `true` if the ring holds no bytes
+    bool empty() const { return _size == 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPILL_RING_HH
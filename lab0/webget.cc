@@ -1,10 +1,28 @@
 #include "socket.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
+using namespace std::chrono;
 
 void get_URL(const string &host, const string &path) {
     // Your code here.
@@ -31,18 +49,813 @@ void get_URL(const string &host, const string &path) {
     http_tcpsock.close();
 }
 
+/**
+ * 并发抓取模式：epoll驱动的事件循环同时抓取多个URL，每个主机维护若干条keep-alive连接，
+ * 每条连接上流水线式地发送多个请求。响应体按请求的顺序以大块的write写到标准输出或文件：
+ * 排在最前面的请求边收边写，只有排在它后面、提前收到的响应体才暂存在内存中。
+ */
+
+struct Url {
+    string host;
+    string port;
+    string path;
+};
+
+//! \details 接受"http://host[:port]/path"或"host[:port]/path"，路径缺省为"/"
+static Url parse_url(string_view text) {
+    if (text.substr(0, 7) == "http://") {
+        text.remove_prefix(7);
+    }
+    Url url{};
+    size_t slash = text.find('/');
+    string_view authority = text.substr(0, slash);
+    url.path = (slash == string_view::npos) ? "/" : string(text.substr(slash));
+    size_t colon = authority.find(':');
+    url.host = string(authority.substr(0, colon));
+    url.port = (colon == string_view::npos) ? "http" : string(authority.substr(colon + 1));
+    if (url.host.empty()) {
+        throw runtime_error("invalid URL: " + string(text));
+    }
+    return url;
+}
+
+/**
+ * 增量式的HTTP/1.x响应解析器：支持Content-Length、chunked编码以及读到连接关闭为止的响应体
+ */
+class ResponseParser {
+  private:
+    enum class State { Headers, Body, ChunkSize, ChunkData, ChunkCrlf, Trailer, UntilClose, Done };
+    State _state{State::Headers};
+    string _header{};
+    string _line{};
+    size_t _remaining{0};
+    bool _keep_alive{true};
+
+    void parse_headers();
+
+    // 从data中取出一行放入_line(去掉行尾的CRLF)，行不完整时返回false并暂存已读到的部分
+    bool take_line(string_view &data, size_t &consumed);
+
+  public:
+    // 解析data开头的字节，响应体的各段依次交给on_body，返回消耗的字节数；响应完整时complete()为真
+    size_t parse(string_view data, const function<void(string_view)> &on_body);
+
+    // 连接被对端关闭：读到关闭为止的响应体此时完整
+    void finish_at_eof() {
+        if (_state == State::UntilClose) {
+            _state = State::Done;
+        }
+    }
+
+    bool complete() const { return _state == State::Done; }
+
+    // 尚未收到当前响应的任何字节
+    bool idle() const { return _state == State::Headers && _header.empty(); }
+
+    // 当前的响应结束后连接是否还能继续使用
+    bool keep_alive() const { return _keep_alive; }
+
+    void reset() {
+        _state = State::Headers;
+        _header.clear();
+        _line.clear();
+        _remaining = 0;
+        _keep_alive = true;
+    }
+};
+
+static bool equals_ignore_case(const string_view a, const string_view b) {
+    return equal(a.begin(), a.end(), b.begin(), b.end(), [](const char x, const char y) {
+        return tolower(static_cast<unsigned char>(x)) == tolower(static_cast<unsigned char>(y));
+    });
+}
+
+static string_view trim(string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+//! \details 状态行决定默认是否保持连接(HTTP/1.0默认关闭)，首部决定响应体的长度
+void ResponseParser::parse_headers() {
+    string_view headers = _header;
+    size_t line_end = headers.find("\r\n");
+    string_view status_line = headers.substr(0, line_end);
+    if (status_line.substr(0, 5) != "HTTP/") {
+        throw runtime_error("malformed HTTP status line");
+    }
+    _keep_alive = (status_line.substr(0, 8) != "HTTP/1.0");
+    int status = (status_line.size() >= 12) ? atoi(string(status_line.substr(9, 3)).c_str()) : 0;
+
+    /* 1xx是临时响应(如100 Continue、103 Early Hints)，之后才是真正的响应：丢弃它的首部继续解析 */
+    if (status / 100 == 1) {
+        _header.clear();
+        _keep_alive = true;
+        return;
+    }
+
+    optional<size_t> content_length{};
+    bool chunked = false;
+    while (line_end != string_view::npos) {
+        headers.remove_prefix(line_end + 2);
+        line_end = headers.find("\r\n");
+        string_view line = headers.substr(0, line_end);
+        size_t colon = line.find(':');
+        if (colon == string_view::npos) {
+            continue;
+        }
+        string_view name = trim(line.substr(0, colon));
+        string_view value = trim(line.substr(colon + 1));
+        if (equals_ignore_case(name, "Content-Length")) {
+            content_length = strtoull(string(value).c_str(), nullptr, 10);
+        } else if (equals_ignore_case(name, "Transfer-Encoding")) {
+            chunked = equals_ignore_case(value, "chunked");
+        } else if (equals_ignore_case(name, "Connection")) {
+            _keep_alive = equals_ignore_case(value, "keep-alive");
+        }
+    }
+
+    if ((status == 204) || (status == 304)) {
+        _state = State::Done;
+    } else if (chunked) {
+        _state = State::ChunkSize;
+    } else if (content_length.has_value()) {
+        _remaining = content_length.value();
+        _state = (_remaining > 0) ? State::Body : State::Done;
+    } else {
+        _keep_alive = false;
+        _state = State::UntilClose;
+    }
+}
+
+bool ResponseParser::take_line(string_view &data, size_t &consumed) {
+    size_t newline = data.find('\n');
+    size_t length = (newline == string_view::npos) ? data.size() : newline + 1;
+    _line.append(data.substr(0, length));
+    data.remove_prefix(length);
+    consumed += length;
+    if (newline == string_view::npos) {
+        return false;
+    }
+    while (!_line.empty() && (_line.back() == '\n' || _line.back() == '\r')) {
+        _line.pop_back();
+    }
+    return true;
+}
+
+size_t ResponseParser::parse(string_view data, const function<void(string_view)> &on_body) {
+    size_t consumed = 0;
+    while (!data.empty() && _state != State::Done) {
+        switch (_state) {
+            case State::Headers: {
+                /* 首部可能跨越多次read，从上次的末尾前3个字节开始查找空行 */
+                size_t search_from = (_header.size() > 3) ? _header.size() - 3 : 0;
+                _header.append(data);
+                size_t end = _header.find("\r\n\r\n", search_from);
+                if (end == string::npos) {
+                    consumed += data.size();
+                    data = {};
+                    break;
+                }
+                size_t used = end + 4 - (_header.size() - data.size());
+                _header.resize(end + 2);
+                consumed += used;
+                data.remove_prefix(used);
+                parse_headers();
+                break;
+            }
+            case State::Body: {
+                size_t length = min(_remaining, data.size());
+                on_body(data.substr(0, length));
+                data.remove_prefix(length);
+                consumed += length;
+                _remaining -= length;
+                _state = (_remaining == 0) ? State::Done : State::Body;
+                break;
+            }
+            case State::ChunkSize:
+                if (take_line(data, consumed)) {
+                    _remaining = strtoull(_line.c_str(), nullptr, 16);
+                    _line.clear();
+                    _state = (_remaining == 0) ? State::Trailer : State::ChunkData;
+                }
+                break;
+            case State::ChunkData: {
+                size_t length = min(_remaining, data.size());
+                on_body(data.substr(0, length));
+                data.remove_prefix(length);
+                consumed += length;
+                _remaining -= length;
+                _state = (_remaining == 0) ? State::ChunkCrlf : State::ChunkData;
+                break;
+            }
+            case State::ChunkCrlf:
+                if (take_line(data, consumed)) {
+                    _line.clear();
+                    _state = State::ChunkSize;
+                }
+                break;
+            case State::Trailer:
+                if (take_line(data, consumed)) {
+                    _state = _line.empty() ? State::Done : State::Trailer;
+                    _line.clear();
+                }
+                break;
+            case State::UntilClose:
+                on_body(data);
+                consumed += data.size();
+                data = {};
+                break;
+            case State::Done:
+                break;
+        }
+    }
+    return consumed;
+}
+
+/**
+ * 响应体的输出：写到一个目录下的文件(每个请求一个文件)，或以大块缓冲写到标准输出，或直接丢弃。
+ * 各请求的响应体按请求的顺序分段写入，一个请求写完后才会写下一个请求。
+ */
+class BodySink {
+  private:
+    static constexpr size_t FLUSH_THRESHOLD = 1 << 20;
+
+    string _directory;
+    bool _discard;
+    string _buffer{};
+
+    // 写到目录时正在写入的文件及其对应的请求
+    int _file_fd{-1};
+    size_t _file_id{0};
+
+    static void write_all(const int fd, string_view data) {
+        while (!data.empty()) {
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw unix_error("write");
+            }
+            data.remove_prefix(written);
+        }
+    }
+
+    void open_file(const size_t id) {
+        if (_file_fd >= 0 && _file_id == id) {
+            return;
+        }
+        close_file();
+        string name = _directory + "/" + to_string(id);
+        _file_fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_file_fd < 0) {
+            throw unix_error("open " + name);
+        }
+        _file_id = id;
+    }
+
+    void close_file() {
+        if (_file_fd >= 0) {
+            ::close(_file_fd);
+            _file_fd = -1;
+        }
+    }
+
+  public:
+    BodySink(const string &directory, const bool discard) : _directory(directory), _discard(discard) {}
+    BodySink(const BodySink &) = delete;
+    BodySink &operator=(const BodySink &) = delete;
+    ~BodySink() {
+        close_file();
+        try {
+            flush();
+        } catch (const exception &e) {
+            cerr << e.what() << "\n";
+        }
+    }
+
+    //! \details 写到标准输出时，不小于缓冲阈值的一段绕过缓冲区直接写出，避免多一次拷贝
+    void write(const size_t id, const string_view data) {
+        if (_discard || data.empty()) {
+            return;
+        }
+        if (!_directory.empty()) {
+            open_file(id);
+            write_all(_file_fd, data);
+            return;
+        }
+        if (_buffer.size() + data.size() > FLUSH_THRESHOLD) {
+            flush();
+        }
+        if (data.size() >= FLUSH_THRESHOLD) {
+            write_all(STDOUT_FILENO, data);
+        } else {
+            _buffer.append(data);
+        }
+    }
+
+    // 请求id的响应体已全部写入；写到目录时响应体为空也会创建文件
+    void finish(const size_t id) {
+        if (_discard || _directory.empty()) {
+            return;
+        }
+        open_file(id);
+        close_file();
+    }
+
+    void flush() {
+        write_all(STDOUT_FILENO, _buffer);
+        _buffer.clear();
+    }
+};
+
+struct FetchOptions {
+    size_t connections_per_host{4};
+    size_t pipeline_depth{8};
+    size_t repeat{1};
+    size_t max_retries{3};
+    string output_directory{};
+    bool discard{false};
+};
+
+class ConcurrentFetcher {
+  private:
+    struct Request {
+        Url url;
+        string body{};       // 排在前面的请求尚未写完时，提前收到的响应体暂存在这里
+        size_t received{0};  // 本次发送收到的响应体字节数
+        size_t streamed{0};  // 已写给BodySink的字节数：重新发送后收到的这部分前缀不再写出
+        steady_clock::time_point start{};
+        size_t retries{0};
+        bool done{false};
+    };
+
+    struct HostPool;
+
+    struct Connection {
+        TCPSocket socket;
+        HostPool *pool;
+        deque<size_t> in_flight{};  // 已发送、按发送顺序等待响应的请求
+        string output{};            // 尚未写出的请求
+        size_t output_offset{0};
+        bool want_write{false};
+        ResponseParser parser{};
+        size_t responses{0};  // 已在这条连接上收到的完整响应数
+        bool connecting{true};  // 非阻塞connect尚未完成，完成时连接变为可写
+        uint32_t serial;        // 连接的编号：关闭后fd可能被新连接复用，epoll事件凭编号区分新旧连接
+
+        Connection(TCPSocket &&sock, HostPool *host_pool, const uint32_t connection_serial)
+            : socket(move(sock)), pool(host_pool), serial(connection_serial) {}
+        Connection(const Connection &) = delete;
+        Connection &operator=(const Connection &) = delete;
+    };
+
+    struct HostPool {
+        Address address;
+        string host_header;
+        deque<size_t> pending{};
+        vector<int> connections{};
+
+        // 服务器不保持连接(如HTTP/1.0，或连接上的第一个响应就要求关闭)时每条连接只发送一个请求
+        bool persistent{true};
+
+        HostPool(const Address &addr, const string &host) : address(addr), host_header(host) {}
+    };
+
+    FetchOptions _options;
+    BodySink _sink;
+    int _epoll_fd;
+    vector<Request> _requests{};
+    unordered_map<string, unique_ptr<HostPool>> _pools{};
+    unordered_map<int, unique_ptr<Connection>> _connections{};
+    size_t _remaining{0};
+    size_t _errors{0};
+    uint32_t _next_serial{0};
+    vector<double> _latencies_ms{};
+
+    // 响应体按请求的顺序输出：先完成的请求等待排在它前面的请求完成
+    size_t _next_delivery{0};
+
+    // epoll事件携带的连接标识：高32位为连接编号，低32位为fd
+    static uint64_t event_key(const Connection &connection);
+    // 事件所属的连接仍然打开(没有被关闭，fd也没有被新连接复用)时返回它的fd
+    optional<int> live_connection(const uint64_t key) const;
+    void update_interest(Connection &connection);
+    void open_connection(HostPool &pool);
+    // 关闭连接的原因：上一个响应正常结束后服务器不再保持连接 / 连接出错或响应不完整 / 收到无法对应的数据
+    enum class CloseReason { Finished, Broken, Unexpected };
+    void close_connection(const int fd, const CloseReason reason);
+    void dispatch(HostPool &pool);
+    void complete(Connection &connection);
+    void fail(const size_t id);
+    void receive_body(const size_t id, string_view data);
+    void deliver_ready();
+    void on_readable(const int fd);
+    void on_writable(const int fd);
+
+  public:
+    ConcurrentFetcher(const FetchOptions &options);
+    ConcurrentFetcher(const ConcurrentFetcher &) = delete;
+    ConcurrentFetcher &operator=(const ConcurrentFetcher &) = delete;
+    ~ConcurrentFetcher() { ::close(_epoll_fd); }
+
+    void add(const Url &url);
+    void run();
+
+    // 最终失败的请求数
+    size_t errors() const { return _errors; }
+};
+
+ConcurrentFetcher::ConcurrentFetcher(const FetchOptions &options)
+    : _options(options), _sink(options.output_directory, options.discard), _epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (_epoll_fd < 0) {
+        throw unix_error("epoll_create1");
+    }
+}
+
+void ConcurrentFetcher::add(const Url &url) {
+    string key = url.host + ":" + url.port;
+    auto it = _pools.find(key);
+    if (it == _pools.end()) {
+        string host_header = (url.port == "http" || url.port == "80") ? url.host : key;
+        it = _pools.emplace(key, make_unique<HostPool>(Address(url.host, url.port), host_header)).first;
+    }
+    it->second->pending.push_back(_requests.size());
+    _requests.push_back({url});
+    ++_remaining;
+}
+
+uint64_t ConcurrentFetcher::event_key(const Connection &connection) {
+    return (static_cast<uint64_t>(connection.serial) << 32) | static_cast<uint32_t>(connection.socket.fd_num());
+}
+
+optional<int> ConcurrentFetcher::live_connection(const uint64_t key) const {
+    const int fd = static_cast<int>(key & 0xffffffff);
+    auto it = _connections.find(fd);
+    if (it == _connections.end() || it->second->serial != (key >> 32)) {
+        return nullopt;
+    }
+    return fd;
+}
+
+void ConcurrentFetcher::update_interest(Connection &connection) {
+    epoll_event event{};
+    event.events = static_cast<uint32_t>(EPOLLIN) | (connection.want_write ? EPOLLOUT : 0u);
+    event.data.u64 = event_key(connection);
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, connection.socket.fd_num(), &event) < 0) {
+        throw unix_error("epoll_ctl");
+    }
+}
+
+//! \details 非阻塞地发起连接，连接建立(或失败)时套接字变为可写，由on_writable检查结果；
+//! 连接建立前分配给它的请求先缓存在output中
+void ConcurrentFetcher::open_connection(HostPool &pool) {
+    TCPSocket socket;
+    socket.set_blocking(false);
+    if (::connect(socket.fd_num(), pool.address, pool.address.size()) < 0 && errno != EINPROGRESS) {
+        throw unix_error("connect");
+    }
+    int fd = socket.fd_num();
+    auto connection = make_unique<Connection>(move(socket), &pool, _next_serial++);
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = event_key(*connection);
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw unix_error("epoll_ctl");
+    }
+    connection->want_write = true;
+    _connections.emplace(fd, move(connection));
+    pool.connections.push_back(fd);
+}
+
+//! \details 连接关闭时尚未收到完整响应的请求放回主机队列的队首，按原顺序重新发送。
+//! 连接出错时只有正在接收响应的第一个请求计入重试次数，排在它后面的请求不受影响。
+void ConcurrentFetcher::close_connection(const int fd, const CloseReason reason) {
+    auto it = _connections.find(fd);
+    Connection &connection = *it->second;
+    HostPool &pool = *connection.pool;
+    for (auto id = connection.in_flight.rbegin(); id != connection.in_flight.rend(); ++id) {
+        const bool charged = (reason == CloseReason::Broken) && (*id == connection.in_flight.front());
+        if (reason != CloseReason::Unexpected &&
+            (!charged || ++_requests[*id].retries <= _options.max_retries)) {
+            _requests[*id].body.clear();
+            _requests[*id].received = 0;
+            pool.pending.push_front(*id);
+        } else {
+            fail(*id);
+        }
+    }
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    pool.connections.erase(find(pool.connections.begin(), pool.connections.end(), fd));
+    _connections.erase(it);
+}
+
+//! \details 先填满已有连接的流水线，仍有等待的请求时再新建连接，直到达到每个主机的连接数上限
+void ConcurrentFetcher::dispatch(HostPool &pool) {
+    while (!pool.pending.empty()) {
+        Connection *target = nullptr;
+        for (const int fd : pool.connections) {
+            Connection &connection = *_connections.at(fd);
+            if (connection.in_flight.size() < (pool.persistent ? _options.pipeline_depth : 1) &&
+                (target == nullptr || connection.in_flight.size() < target->in_flight.size())) {
+                target = &connection;
+            }
+        }
+        const bool below_limit = pool.connections.size() < _options.connections_per_host;
+        if (target == nullptr || (!target->in_flight.empty() && below_limit)) {
+            if (below_limit) {
+                try {
+                    open_connection(pool);
+                    continue;
+                } catch (const exception &e) {
+                    cerr << e.what() << "\n";
+                    if (pool.connections.empty()) {
+                        while (!pool.pending.empty()) {
+                            fail(pool.pending.front());
+                            pool.pending.pop_front();
+                        }
+                        return;
+                    }
+                }
+            }
+            if (target == nullptr) {
+                return;
+            }
+        }
+
+        size_t id = pool.pending.front();
+        pool.pending.pop_front();
+        Request &request = _requests[id];
+        request.start = steady_clock::now();
+        target->output += "GET " + request.url.path + " HTTP/1.1\r\nHost: " + pool.host_header + "\r\n\r\n";
+        target->in_flight.push_back(id);
+        if (!target->want_write) {
+            target->want_write = true;
+            update_interest(*target);
+        }
+    }
+}
+
+void ConcurrentFetcher::complete(Connection &connection) {
+    size_t id = connection.in_flight.front();
+    connection.in_flight.pop_front();
+    ++connection.responses;
+    Request &request = _requests[id];
+    _latencies_ms.push_back(duration<double, milli>(steady_clock::now() - request.start).count());
+    request.done = true;
+    --_remaining;
+    deliver_ready();
+}
+
+void ConcurrentFetcher::fail(const size_t id) {
+    cerr << "failed: " << _requests[id].url.host << _requests[id].url.path << "\n";
+    _requests[id].done = true;
+    string().swap(_requests[id].body);
+    ++_errors;
+    --_remaining;
+    deliver_ready();
+}
+
+//! \details 重新发送的请求收到的前streamed个字节已经写出过，跳过它们；
+//! 排在最前面的请求直接写给BodySink，其余的暂存到轮到它们时再写
+void ConcurrentFetcher::receive_body(const size_t id, string_view data) {
+    Request &request = _requests[id];
+    const size_t skip =
+        (request.streamed > request.received) ? min(request.streamed - request.received, data.size()) : 0;
+    request.received += data.size();
+    data.remove_prefix(skip);
+    if (id == _next_delivery) {
+        _sink.write(id, data);
+        request.streamed += data.size();
+    } else {
+        request.body.append(data);
+    }
+}
+
+//! \details 写出排在最前面的请求暂存的响应体；它已完成时依次轮到下一个请求，
+//! 直到遇到一个尚未完成的请求，之后它的响应体边收边写
+void ConcurrentFetcher::deliver_ready() {
+    while (_next_delivery < _requests.size()) {
+        Request &request = _requests[_next_delivery];
+        if (!request.body.empty()) {
+            _sink.write(_next_delivery, request.body);
+            request.streamed += request.body.size();
+            string().swap(request.body);
+        }
+        if (!request.done) {
+            break;
+        }
+        _sink.finish(_next_delivery);
+        ++_next_delivery;
+    }
+}
+
+void ConcurrentFetcher::on_writable(const int fd) {
+    Connection &connection = *_connections.at(fd);
+    HostPool &pool = *connection.pool;
+    if (connection.connecting) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+            cerr << "connect: " << strerror((error != 0) ? error : errno) << "\n";
+            close_connection(fd, CloseReason::Broken);
+            dispatch(pool);
+            return;
+        }
+        connection.connecting = false;
+    }
+    while (connection.output_offset < connection.output.size()) {
+        ssize_t written = ::send(fd,
+                                 connection.output.data() + connection.output_offset,
+                                 connection.output.size() - connection.output_offset,
+                                 MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            close_connection(fd, CloseReason::Broken);
+            dispatch(pool);
+            return;
+        }
+        connection.output_offset += written;
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    connection.want_write = false;
+    update_interest(connection);
+}
+
+//! \details 一次读入最多64KiB；对端关闭连接或不再保持连接时，剩余的请求换一条连接重新发送
+void ConcurrentFetcher::on_readable(const int fd) {
+    char buffer[65536];
+    Connection &connection = *_connections.at(fd);
+    HostPool &pool = *connection.pool;
+    while (true) {
+        ssize_t bytes_read = ::read(fd, buffer, sizeof(buffer));
+        if (bytes_read < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            close_connection(fd, CloseReason::Broken);
+            dispatch(pool);
+            return;
+        }
+        if (bytes_read == 0) {
+            connection.parser.finish_at_eof();
+            if (!connection.in_flight.empty() && connection.parser.complete()) {
+                complete(connection);
+                connection.parser.reset();
+            }
+            // 服务器在两个响应之间关闭连接是正常的，一个响应也没有发送就关闭则视为出错
+            const bool finished =
+                connection.in_flight.empty() || (connection.parser.idle() && connection.responses > 0);
+            close_connection(fd, finished ? CloseReason::Finished : CloseReason::Broken);
+            dispatch(pool);
+            return;
+        }
+
+        string_view data(buffer, bytes_read);
+        while (!data.empty()) {
+            if (connection.in_flight.empty()) {
+                close_connection(fd, CloseReason::Unexpected);
+                dispatch(pool);
+                return;
+            }
+            const size_t id = connection.in_flight.front();
+            data.remove_prefix(connection.parser.parse(data, [this, id](string_view body) { receive_body(id, body); }));
+            if (!connection.parser.complete()) {
+                continue;
+            }
+            bool keep_alive = connection.parser.keep_alive();
+            bool first_response = (connection.responses == 0);
+            complete(connection);
+            connection.parser.reset();
+            if (!keep_alive) {
+                // 保持过连接的服务器之后关闭连接(如达到单连接的请求数上限)只影响这一条连接
+                if (first_response) {
+                    pool.persistent = false;
+                }
+                close_connection(fd, CloseReason::Finished);
+                dispatch(pool);
+                return;
+            }
+        }
+    }
+    dispatch(pool);
+}
+
+void ConcurrentFetcher::run() {
+    const auto start = steady_clock::now();
+    for (auto &[key, pool] : _pools) {
+        dispatch(*pool);
+    }
+    vector<epoll_event> events(256);
+    while (_remaining > 0) {
+        int ready = epoll_wait(_epoll_fd, events.data(), events.size(), -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw unix_error("epoll_wait");
+        }
+        for (int i = 0; i < ready; ++i) {
+            // on_writable可能关闭连接，dispatch又可能让新连接复用同一个fd，因此每次处理前都重新确认
+            const uint64_t key = events[i].data.u64;
+            optional<int> fd = live_connection(key);
+            if ((events[i].events & EPOLLOUT) && fd.has_value()) {
+                on_writable(fd.value());
+            }
+            fd = live_connection(key);
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && fd.has_value()) {
+                on_readable(fd.value());
+            }
+        }
+    }
+    _sink.flush();
+    const double elapsed = duration<double>(steady_clock::now() - start).count();
+
+    sort(_latencies_ms.begin(), _latencies_ms.end());
+    const auto percentile = [this](const double p) {
+        return _latencies_ms.empty() ? 0.0 : _latencies_ms[static_cast<size_t>(p * (_latencies_ms.size() - 1))];
+    };
+    cerr << "webget requests=" << _requests.size() << " errors=" << _errors << " elapsed_ms=" << elapsed * 1000
+         << " requests/sec=" << (_requests.size() - _errors) / elapsed << " latency_p50_ms=" << percentile(0.5)
+         << " latency_p90_ms=" << percentile(0.9) << " latency_p99_ms=" << percentile(0.99)
+         << " latency_max_ms=" << percentile(1.0) << "\n";
+}
+
+static void usage(const char *program) {
+    cerr << "Usage: " << program << " HOST PATH\n";
+    cerr << "\tExample: " << program << " stanford.edu /class/cs144\n";
+    cerr << "   or: " << program << " [-c CONNS] [-d DEPTH] [-n REPEAT] [-o DIR | -q] URL...\n";
+    cerr << "\tFetch every URL (host[:port]/path) REPEAT times, with up to CONNS keep-alive connections\n";
+    cerr << "\tper host and DEPTH pipelined requests per connection. Bodies go to stdout, to DIR/<n>,\n";
+    cerr << "\tor nowhere (-q); requests/sec and latency percentiles are printed to stderr.\n";
+}
+
 int main(int argc, char *argv[]) {
     try {
         if (argc <= 0) {
             abort();  // For sticklers: don't try to access argv[0] if argc <= 0.   
         }
 
+        // 参数不是"HOST PATH"的形式时(带选项、只有一个URL或多于两个参数)进入并发抓取模式
+        const bool host_and_path =
+            (argc == 3) && (argv[1][0] != '-') && (string_view(argv[1]).find('/') == string_view::npos) &&
+            (argv[2][0] == '/');
+        if (argc >= 2 && !host_and_path) {
+            FetchOptions options;
+            vector<Url> urls;
+            for (int i = 1; i < argc; ++i) {
+                const string arg = argv[i];
+                if (arg == "-q") {
+                    options.discard = true;
+                } else if ((arg == "-c" || arg == "-d" || arg == "-n" || arg == "-o") && i + 1 < argc) {
+                    const string value = argv[++i];
+                    if (arg == "-o") {
+                        options.output_directory = value;
+                    } else {
+                        const size_t number = max<size_t>(stoul(value), 1);
+                        (arg == "-c" ? options.connections_per_host
+                                     : arg == "-d" ? options.pipeline_depth : options.repeat) = number;
+                    }
+                } else if (arg[0] == '-') {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                } else {
+                    urls.push_back(parse_url(arg));
+                }
+            }
+            if (urls.empty()) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            ConcurrentFetcher fetcher(options);
+            for (size_t round = 0; round < options.repeat; ++round) {
+                for (const Url &url : urls) {
+                    fetcher.add(url);
+                }
+            }
+            fetcher.run();
+            return (fetcher.errors() > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
         // The program takes two command-line arguments: the hostname and "path" part of the URL.
         // Print the usage message unless there are these two arguments (plus the program name
         // itself, so arg count = 3 in total).
         if (argc != 3) {
-            cerr << "Usage: " << argv[0] << " HOST PATH\n";
-            cerr << "\tExample: " << argv[0] << " stanford.edu /class/cs144\n";
+            usage(argv[0]);
             return EXIT_FAILURE;
         }
 
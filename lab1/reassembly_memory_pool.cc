@@ -0,0 +1,58 @@
+#include "reassembly_memory_pool.hh"
+
+#include "stream_reassembler.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+void ReassemblyMemoryPool::join(StreamReassembler *reassembler) { _members.push_back(reassembler); }
+
+void ReassemblyMemoryPool::leave(StreamReassembler *reassembler) {
+    auto it = find(_members.begin(), _members.end(), reassembler);
+    if (it != _members.end()) {
+        *it = _members.back();
+        _members.pop_back();
+    }
+}
+
+//! \details 峰值在修剪之后记录：超出上限的字节只是暂时计入，随即被丢弃，不算作池实际持有的字节
+void ReassemblyMemoryPool::charge(const size_t bytes) {
+    _charged += bytes;
+    if (_charged > _limit) {
+        prune();
+    }
+    _stats.peak_charged_bytes = max<uint64_t>(_stats.peak_charged_bytes, _charged);
+}
+
+void ReassemblyMemoryPool::release(const size_t bytes) { _charged -= min(bytes, _charged); }
+
+//! \details 每轮选出乱序数据延伸得最远(最后一个乱序字节距下一个按序字节最远)的流，从其末尾的区间丢弃
+//! 不超过超出量的字节；该流的末端因此前移，下一轮可能轮到其他流。被丢弃的字节通过release归还。
+void ReassemblyMemoryPool::prune() {
+    if (_pruning) {
+        return;
+    }
+    _pruning = true;
+    ++_stats.prune_events;
+    while (_charged > _limit) {
+        StreamReassembler *victim = nullptr;
+        uint64_t farthest = 0;
+        for (StreamReassembler *member : _members) {
+            uint64_t reach = member->out_of_order_reach();
+            if (reach > farthest) {
+                farthest = reach;
+                victim = member;
+            }
+        }
+        if (victim == nullptr) {
+            break;
+        }
+        size_t dropped = victim->prune_tail(_charged - _limit);
+        _stats.pruned_bytes += dropped;
+        if (dropped == 0) {
+            break;
+        }
+    }
+    _pruning = false;
+}
@@ -0,0 +1,72 @@
+#ifndef SPONGE_LIBSPONGE_REASSEMBLY_MEMORY_POOL_HH
+#define SPONGE_LIBSPONGE_REASSEMBLY_MEMORY_POOL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class StreamReassembler;
+
+//! \brief Counters of a ReassemblyMemoryPool
+struct ReassemblyPoolStats {
+    uint64_t peak_charged_bytes{0};  //!< high-water mark of the out-of-order bytes held, after pruning
+    uint64_t prune_events{0};        //!< times the pool went over its limit and pruned
+    uint64_t pruned_bytes{0};        //!< out-of-order bytes dropped by pruning
+};
+
+//! \brief A memory budget for out-of-order bytes, shared by many StreamReassemblers.
+
+//! Every attached reassembler charges the bytes it holds out of order to the
+//! pool. When a charge takes the pool over its limit, the pool prunes stored
+//! bytes until it is back under the limit, like the kernel's out-of-order
+//! queue pruning. It starts with the flow whose stored data reaches farthest
+//! past its next in-order byte, and drops that flow's highest-indexed bytes
+//! first. Pruned bytes were never cumulatively acknowledged, so the peer
+//! retransmits them, even those it has already seen in a SACK block.
+//!
+//! A pool is not thread-safe. Reassemblers running on different threads need
+//! separate pools, for instance one per shard with a slice of the host budget.
+class ReassemblyMemoryPool {
+  private:
+    // 伙伴类：StreamReassembler通过下面的私有接口加入、离开与记账
+    friend class StreamReassembler;
+
+    size_t _limit;
+    size_t _charged{0};
+    std::vector<StreamReassembler *> _members{};
+    ReassemblyPoolStats _stats{};
+
+    // 正在修剪时不再重入：被修剪的重组器只会归还字节
+    bool _pruning{false};
+
+    void join(StreamReassembler *reassembler);
+    void leave(StreamReassembler *reassembler);
+
+    // 记入新存储的乱序字节，超出上限时修剪
+    void charge(const size_t bytes);
+
+    // 归还已重组或被丢弃的乱序字节
+    void release(const size_t bytes);
+
+    // 从离按序交付最远的流开始丢弃乱序字节，直到回到上限以内
+    void prune();
+
+  public:
+    //! \param limit the most out-of-order bytes all attached reassemblers may hold together
+    explicit ReassemblyMemoryPool(const size_t limit) : _limit(limit) {}
+    ReassemblyMemoryPool(const ReassemblyMemoryPool &) = delete;
+    ReassemblyMemoryPool &operator=(const ReassemblyMemoryPool &) = delete;
+
+    //! \returns the limit in bytes
+    size_t limit() const { return _limit; }
+
+    //! \returns the out-of-order bytes currently held by attached reassemblers
+    size_t charged() const { return _charged; }
+
+    //! \returns the number of attached reassemblers
+    size_t members() const { return _members.size(); }
+
+    const ReassemblyPoolStats &stats() const { return _stats; }
+};
+
+#endif  // SPONGE_LIBSPONGE_REASSEMBLY_MEMORY_POOL_HH
@@ -1,5 +1,7 @@
 #include "stream_reassembler.hh"
 
+#include <limits>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -12,13 +14,63 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) 
-    : _output(capacity), _capacity(capacity) {}
+StreamReassembler::StreamReassembler(const size_t capacity, const ReassemblerBackend backend)
+    : _output(capacity), _capacity(capacity), _backend(backend) {
+    if (_backend == ReassemblerBackend::Bitmap) {
+        size_t ring_size = 64;
+        while (ring_size < capacity) {
+            ring_size <<= 1;
+        }
+        _ring.resize(ring_size);
+        _present.resize(ring_size / 64);
+        _ring_mask = ring_size - 1;
+    }
+}
+
+StreamReassembler::~StreamReassembler() {
+    if (_pool) {
+        _pool->release(_pool_charged);
+        _pool->leave(this);
+    }
+}
+
+StreamReassembler::StreamReassembler(StreamReassembler &&other)
+    : _output(0), _capacity(0), _backend(other._backend) {
+    *this = move(other);
+}
+
+//! \details 先退出自己所在的内存池，再接管other的全部状态；other在内存池中的位置改由this占据，
+//! other不再属于任何内存池
+StreamReassembler &StreamReassembler::operator=(StreamReassembler &&other) {
+    if (this == &other) {
+        return *this;
+    }
+    attach_memory_pool(nullptr);
+    _output = move(other._output);
+    _capacity = other._capacity;
+    _eof = other._eof;
+    _eof_index = other._eof_index;
+    _unassembled_segments = move(other._unassembled_segments);
+    _unassembled_bytes = exchange(other._unassembled_bytes, 0);
+    _backend = other._backend;
+    _ring = move(other._ring);
+    _present = move(other._present);
+    _ring_mask = other._ring_mask;
+    _ring_end = other._ring_end;
+    _pool = move(other._pool);
+    _pool_charged = exchange(other._pool_charged, 0);
+    _pruned_bytes = other._pruned_bytes;
+    if (_pool) {
+        _pool->leave(&other);
+        _pool->join(this);
+    }
+    return *this;
+}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
+void StreamReassembler::push_substring(const string_view data, const size_t index, const bool eof) {
     /* 动态地获取关键index值 */
     size_t first_unread_index = _output.bytes_read();
     size_t first_unassembled_index = first_unread_index + _output.buffer_size();
@@ -28,9 +80,13 @@ void StreamReassembler::push_substring(const string &data, const size_t index, c
     if ((index+data_len < first_unassembled_index) || 
         (index >= first_unacceptable_index)) {
         return;
-    } else if (data_len == 0) { // 传入data为空时的加速处理
-        _eof |= eof; // 处理为EOF的碎片
-        if (empty() && _eof) {  
+    }
+    if (eof && (index+data_len <= first_unacceptable_index)) { // 最后一个字节数据有效时记录流的结束位置
+        _eof = true;
+        _eof_index = index+data_len;
+    }
+    if (data_len == 0) { // 传入data为空时的加速处理
+        if (_eof && (_output.bytes_written() == _eof_index)) {
             _output.end_input();
         }
         return;
@@ -48,37 +104,282 @@ void StreamReassembler::push_substring(const string &data, const size_t index, c
     // 去尾
     if (index+data_len <= first_unacceptable_index) {
         substr_len = data_len-substr_begin_pos;
-        _eof |= eof; // 尾部数据全部有效，即最后一个字节数据有效，根据eof改变_eof值
     } else {
         size_t overflow_bytes = index+data_len - first_unacceptable_index;
         substr_len = data_len-substr_begin_pos - overflow_bytes;
     }
-    string segment = data.substr(substr_begin_pos, substr_len);
+    /* 与输出流连续的子串直接写入输出流(快速路径)，否则按区间存储 */
+    if (_backend == ReassemblerBackend::Bitmap) {
+        if (new_index == first_unassembled_index) {
+            _output.write(data.substr(substr_begin_pos, substr_len));
+            if (_unassembled_bytes > 0) {  // 没有乱序字节时无需清理位图
+                _unassembled_bytes -= mark_present(new_index, new_index + substr_len, false);
+            }
+        } else {
+            store_in_ring(data, substr_begin_pos, substr_len, new_index);
+        }
+        assemble_ring();
+    } else if (new_index == first_unassembled_index) {
+        _output.write(data.substr(substr_begin_pos, substr_len));
+        assemble_stored_segments();
+    } else {
+        store_segment(string(data.substr(substr_begin_pos, substr_len)), new_index);
+    }
+
+    if (_eof && (_output.bytes_written() == _eof_index))
+        _output.end_input();
+    update_pool_charge();
+}
+
+//! \details 新片段与已存储片段重叠的部分以已存储的数据为准：先用前一个片段裁掉新片段的头部，
+//! 再删除被新片段完全覆盖的片段，遇到只被部分覆盖的片段时裁掉新片段的尾部。
+void StreamReassembler::store_segment(string &&data, const size_t index) {
+    size_t begin = index, end = index + data.length();
+
+    /* 起始位置不大于begin的最后一个片段，可能覆盖新片段的头部 */
+    auto it = _unassembled_segments.upper_bound(begin);
+    if (it != _unassembled_segments.begin()) {
+        auto prev = std::prev(it);
+        size_t prev_end = prev->first + prev->second.length();
+        if (prev_end >= end) {
+            return;
+        }
+        begin = max(begin, prev_end);
+    }
 
-    /* 利用unordered_map特性，合并重组子串 */
-    size_t tmp_index = new_index;
-    for (char it : segment) {
-        if (_unassembled_segments.count(tmp_index) == 0) 
-            _unassembled_segments.emplace(tmp_index, it);
-        ++tmp_index;
+    /* 起始位置落在[begin, end)内的片段 */
+    while (it != _unassembled_segments.end() && it->first < end) {
+        size_t it_end = it->first + it->second.length();
+        if (it_end > end) {
+            end = it->first;
+            break;
+        }
+        _unassembled_bytes -= it->second.length();
+        it = _unassembled_segments.erase(it);
     }
 
-    /* push重组的片段到_output中 */ 
-    string pushed_segment;
-    if (new_index == first_unassembled_index) {
-        auto it = _unassembled_segments.find(new_index);
-        while (it != _unassembled_segments.end()) {
-            pushed_segment.push_back(it->second);
-            _unassembled_segments.erase(it);
-            it = _unassembled_segments.find(++new_index);
+    if (begin < end) {
+        if (end - begin < data.length()) {
+            data = data.substr(begin - index, end - begin);
         }
-        _output.write(move(pushed_segment));
+        _unassembled_segments.emplace_hint(it, begin, move(data));
+        _unassembled_bytes += end - begin;
     }
+}
 
-    if (_eof && empty())
-        _output.end_input();
+void StreamReassembler::assemble_stored_segments() {
+    size_t first_unassembled_index = _output.bytes_written();
+    auto it = _unassembled_segments.begin();
+    while (it != _unassembled_segments.end() && it->first <= first_unassembled_index) {
+        size_t it_end = it->first + it->second.length();
+        if (it_end > first_unassembled_index) {
+            string_view unassembled = string_view(it->second).substr(first_unassembled_index - it->first);
+            first_unassembled_index += _output.write(unassembled);
+        }
+        _unassembled_bytes -= it->second.length();
+        it = _unassembled_segments.erase(it);
+    }
+}
+
+void StreamReassembler::store_in_ring(const string_view data, const size_t pos, const size_t len, const size_t index) {
+    size_t ring_pos = index & _ring_mask;
+    size_t first_len = min(len, _ring.size() - ring_pos);
+    data.copy(_ring.data() + ring_pos, first_len, pos);
+    data.copy(_ring.data(), len - first_len, pos + first_len);
+    _ring_end = (_unassembled_bytes == 0) ? index + len : max(_ring_end, index + len);
+    _unassembled_bytes += mark_present(index, index + len, true);
+}
+
+void StreamReassembler::assemble_ring() {
+    size_t first_unassembled_index = _output.bytes_written();
+    size_t run = present_run(first_unassembled_index, _unassembled_bytes);
+    if (run == 0) {
+        return;
+    }
+    size_t ring_pos = first_unassembled_index & _ring_mask;
+    size_t first_len = min(run, _ring.size() - ring_pos);
+    _output.write(string_view(_ring).substr(ring_pos, first_len));
+    _output.write(string_view(_ring).substr(0, run - first_len));
+    _unassembled_bytes -= mark_present(first_unassembled_index, first_unassembled_index + run, false);
+}
+
+//! \details 逐个64位字处理：每个字内用掩码一次性置位或清零，并用popcount统计改变的位数
+size_t StreamReassembler::mark_present(const size_t begin, const size_t end, const bool present) {
+    size_t changed = 0;
+    for (size_t i = begin; i < end;) {
+        size_t pos = i & _ring_mask;
+        size_t bits = min<size_t>(64 - pos % 64, end - i);
+        uint64_t mask = (bits == 64 ? ~0ull : ((1ull << bits) - 1)) << (pos % 64);
+        uint64_t &word = _present[pos / 64];
+        uint64_t flipped = present ? (mask & ~word) : (mask & word);
+        changed += __builtin_popcountll(flipped);
+        word ^= flipped;
+        i += bits;
+    }
+    return changed;
+}
+
+//! \details 逐个64位字处理：取反后用ctz找到第一个状态不同的字节
+size_t StreamReassembler::present_run(const size_t begin, const size_t limit, const bool present) const {
+    size_t run = 0;
+    while (run < limit) {
+        size_t pos = (begin + run) & _ring_mask;
+        uint64_t word = present ? _present[pos / 64] : ~_present[pos / 64];
+        uint64_t missing = ~(word >> (pos % 64));
+        size_t ones = (missing == 0) ? 64 - pos % 64 : min<size_t>(__builtin_ctzll(missing), 64 - pos % 64);
+        run += ones;
+        if (ones < 64 - pos % 64) {
+            break;
+        }
+    }
+    return min(run, limit);
+}
+
+//! \details 区间后端直接遍历并合并相邻的片段；Bitmap后端从第一个未重组的字节开始，
+//! 交替地跳过缺失的字节与统计已到达的字节，直到所有待重组字节都被统计。
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges(const size_t max_ranges) const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    if (_backend == ReassemblerBackend::Bitmap) {
+        size_t index = _output.bytes_written(), counted = 0;
+        while (counted < _unassembled_bytes && ranges.size() < max_ranges) {
+            index += present_run(index, _capacity, false);
+            size_t run = present_run(index, _unassembled_bytes - counted);
+            ranges.emplace_back(index, index + run);
+            index += run;
+            counted += run;
+        }
+        return ranges;
+    }
+    for (const auto &segment : _unassembled_segments) {
+        size_t end = segment.first + segment.second.length();
+        if (!ranges.empty() && ranges.back().second == segment.first) {
+            ranges.back().second = end;
+        } else if (ranges.size() < max_ranges) {
+            ranges.emplace_back(segment.first, end);
+        } else {
+            break;
+        }
+    }
+    return ranges;
+}
+
+size_t StreamReassembler::set_capacity(const size_t capacity) {
+    size_t first_unread_index = _output.bytes_read();
+    size_t held = _output.buffer_size();
+    if (_unassembled_bytes > 0) {
+        auto ranges = unassembled_ranges(numeric_limits<size_t>::max());
+        held = max<size_t>(held, ranges.back().second - first_unread_index);
+    }
+    /* 输出流可能无法改变容量(如并发模式)，以它实际采用的容量为准 */
+    size_t new_capacity = _output.set_capacity(max(capacity, held));
+    if (_backend == ReassemblerBackend::Bitmap) {
+        resize_ring(new_capacity);
+    }
+    _capacity = new_capacity;
+    return _capacity;
+}
+
+//! \details 环形缓冲区长度为不小于capacity的2的幂(至少64)，长度不变时无需处理；
+//! 否则先把乱序字节连同其位置取出，再写入新的环形缓冲区
+void StreamReassembler::resize_ring(const size_t capacity) {
+    size_t ring_size = 64;
+    while (ring_size < capacity) {
+        ring_size <<= 1;
+    }
+    if (ring_size == _ring.size()) {
+        return;
+    }
+    vector<pair<size_t, string>> stored;
+    for (const auto &range : unassembled_ranges(numeric_limits<size_t>::max())) {
+        size_t ring_pos = range.first & _ring_mask, len = range.second - range.first;
+        size_t first_len = min(len, _ring.size() - ring_pos);
+        stored.emplace_back(range.first, _ring.substr(ring_pos, first_len) + _ring.substr(0, len - first_len));
+    }
+    _ring.assign(ring_size, 0);
+    _present.assign(ring_size / 64, 0);
+    _ring_mask = ring_size - 1;
+    _unassembled_bytes = 0;
+    for (const auto &[index, data] : stored) {
+        store_in_ring(data, 0, data.size(), index);
+    }
+}
+
+//! \param[in] pool the shared pool, or nullptr to stop charging one
+void StreamReassembler::attach_memory_pool(shared_ptr<ReassemblyMemoryPool> pool) {
+    if (_pool) {
+        _pool->release(_pool_charged);
+        _pool->leave(this);
+        _pool_charged = 0;
+    }
+    _pool = move(pool);
+    if (_pool) {
+        _pool->join(this);
+        update_pool_charge();
+    }
+}
+
+//! \details 先更新_pool_charged再记账：超出上限时内存池可能立即修剪本重组器，修剪时按已记账的字节数归还
+void StreamReassembler::update_pool_charge() {
+    if (!_pool || (_unassembled_bytes == _pool_charged)) {
+        return;
+    }
+    if (_unassembled_bytes < _pool_charged) {
+        _pool->release(_pool_charged - _unassembled_bytes);
+        _pool_charged = _unassembled_bytes;
+    } else {
+        size_t added = _unassembled_bytes - _pool_charged;
+        _pool_charged = _unassembled_bytes;
+        _pool->charge(added);
+    }
+}
+
+uint64_t StreamReassembler::out_of_order_reach() const {
+    if (_unassembled_bytes == 0) {
+        return 0;
+    }
+    uint64_t end = _ring_end;
+    if (_backend == ReassemblerBackend::IntervalMap) {
+        const auto &last = *_unassembled_segments.rbegin();
+        end = last.first + last.second.length();
+    }
+    return end - _output.bytes_written();
+}
+
+//! \details 被丢弃的字节从未被累积确认，发送方会重传；区间后端截短或删除最后一个片段，
+//! Bitmap后端清除最后一个区间末尾的位，并把_ring_end前移到剩余的最后一个乱序字节之后
+size_t StreamReassembler::prune_tail(const size_t max_bytes) {
+    if ((_unassembled_bytes == 0) || (max_bytes == 0)) {
+        return 0;
+    }
+    size_t dropped = 0;
+    if (_backend == ReassemblerBackend::Bitmap) {
+        auto ranges = unassembled_ranges(numeric_limits<size_t>::max());
+        const auto [begin, end] = ranges.back();
+        size_t cut = (end - begin > max_bytes) ? end - max_bytes : begin;
+        dropped = mark_present(cut, end, false);
+        if (cut > begin) {
+            _ring_end = cut;
+        } else if (ranges.size() > 1) {
+            _ring_end = ranges[ranges.size() - 2].second;
+        }
+    } else {
+        auto last = prev(_unassembled_segments.end());
+        dropped = min(max_bytes, last->second.length());
+        if (dropped == last->second.length()) {
+            _unassembled_segments.erase(last);
+        } else {
+            last->second.resize(last->second.length() - dropped);
+        }
+    }
+    _unassembled_bytes -= dropped;
+    _pruned_bytes += dropped;
+    if (_pool) {
+        _pool->release(min(dropped, _pool_charged));
+        _pool_charged -= min(dropped, _pool_charged);
+    }
+    return dropped;
 }
 
-size_t StreamReassembler::unassembled_bytes() const { return _unassembled_segments.size(); }
+size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
 
-bool StreamReassembler::empty() const { return _unassembled_segments.empty(); }
+bool StreamReassembler::empty() const { return _unassembled_bytes == 0; }
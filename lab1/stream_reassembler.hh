@@ -2,10 +2,21 @@
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
 #include "byte_stream.hh"
+#include "reassembly_memory_pool.hh"
 
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//! \brief How a StreamReassembler stores out-of-order bytes.
+enum class ReassemblerBackend {
+    IntervalMap,  //!< An ordered map of non-overlapping segments; memory follows the data stored
+    Bitmap,       //!< A ring of `capacity` bytes plus a presence bitmap; memory is fixed at capacity + capacity/8
+};
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
@@ -16,24 +27,80 @@ class StreamReassembler {
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
     bool _eof{}; // 是否接收到EOF的标志
-    std::unordered_map<size_t, char> _unassembled_segments{}; // 利用unordered_map维护重组片段
+    size_t _eof_index{0}; // 流结束的位置，即最后一个字节之后的index
+    std::map<size_t, std::string> _unassembled_segments{}; // 以起始index为键，维护互不重叠的待重组片段
+    size_t _unassembled_bytes{0}; // 待重组片段的总字节数
+    ReassemblerBackend _backend;
+    // Bitmap后端：环形缓冲区长度为2的幂，字节按index & _ring_mask存放，_present中对应位表示该字节是否已到达
+    std::string _ring{};
+    std::vector<uint64_t> _present{};
+    size_t _ring_mask{0};
+
+    // 将[index, index+data.length())区间内尚未被覆盖的部分存入_unassembled_segments
+    void store_segment(std::string &&data, const size_t index);
+
+    // 将已与输出流连续的待重组片段写入输出流
+    void assemble_stored_segments();
+
+    // Bitmap后端：将data中[pos, pos+len)的数据存入环形缓冲区的index处
+    void store_in_ring(const std::string_view data, const size_t pos, const size_t len, const size_t index);
+
+    // Bitmap后端：将已与输出流连续的字节写入输出流
+    void assemble_ring();
+
+    // Bitmap后端：将[begin, end)对应的位置位或清零，返回状态发生改变的位数
+    size_t mark_present(const size_t begin, const size_t end, const bool present);
+
+    // Bitmap后端：返回从begin开始、不超过limit个字节的连续已到达(present为false时为连续缺失)的字节数
+    size_t present_run(const size_t begin, const size_t limit, const bool present = true) const;
+
+    // Bitmap后端：按capacity重新分配环形缓冲区与位图，已存储的乱序字节按新的掩码重新放置
+    void resize_ring(const size_t capacity);
+
+    // Bitmap后端：最后一个乱序字节之后的index，仅在_unassembled_bytes > 0时有效
+    size_t _ring_end{0};
+
+    // 共享的乱序数据内存池，为空时只受_capacity限制；已记入内存池的字节数与累计被修剪的字节数
+    friend class ReassemblyMemoryPool;
+    std::shared_ptr<ReassemblyMemoryPool> _pool{};
+    size_t _pool_charged{0};
+    uint64_t _pruned_bytes{0};
+
+    // 使内存池中记录的字节数与_unassembled_bytes一致，增加时可能触发修剪
+    void update_pool_charge();
+
+    // 供内存池选择修剪对象：最后一个乱序字节距下一个按序字节的距离，没有乱序字节时为0
+    uint64_t out_of_order_reach() const;
+
+    // 供内存池修剪：从最后一个乱序区间的末尾丢弃至多max_bytes个字节，返回丢弃的字节数
+    size_t prune_tail(const size_t max_bytes);
 
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //! \param backend how out-of-order bytes are stored (see ReassemblerBackend)
+    StreamReassembler(const size_t capacity, const ReassemblerBackend backend = ReassemblerBackend::IntervalMap);
+
+    //! \brief A reassembler attached to a ReassemblyMemoryPool is referenced by the pool:
+    //! it is not copied, and moving it hands the pool's reference to the new object.
+    //! A moved-from reassembler may only be assigned to or destroyed.
+    StreamReassembler(StreamReassembler &&other);
+    StreamReassembler &operator=(StreamReassembler &&other);
+    StreamReassembler(const StreamReassembler &) = delete;
+    StreamReassembler &operator=(const StreamReassembler &) = delete;
+    ~StreamReassembler();
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
     //! The StreamReassembler will stay within the memory limits of the `capacity`.
     //! Bytes that would exceed the capacity are silently discarded.
     //!
-    //! \param data the substring
+    //! \param data the substring; only the bytes that have to wait for earlier ones are copied
     //! \param index indicates the index (place in sequence) of the first byte in `data`
     //! \param eof the last byte of `data` will be the last byte in the entire stream
-    void push_substring(const std::string &data, const uint64_t index, const bool eof);
+    void push_substring(const std::string_view data, const uint64_t index, const bool eof);
 
     //! \name Access the reassembled byte stream
     //!@{
@@ -47,6 +114,29 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The ranges of stream indices stored but not yet reassembled
+    //! \param max_ranges at most this many ranges are returned
+    //! \returns disjoint, non-adjacent [begin, end) ranges in ascending order
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges(const size_t max_ranges) const;
+
+    //! \brief Change the capacity of the reassembler and its output stream
+    //! \note The capacity never drops below what is already held: the bytes buffered in the
+    //! stream plus the span up to the last stored out-of-order byte, so nothing accepted is lost.
+    //! A stream that cannot change its capacity (concurrent mode) keeps both at the old capacity.
+    //! \returns the capacity actually set
+    size_t set_capacity(const size_t capacity);
+
+    //! \returns the current capacity
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Charge out-of-order bytes to a pool shared with other reassemblers
+    //! \note When the pool goes over its limit it may drop bytes stored here (see ReassemblyMemoryPool);
+    //! they have not been cumulatively acknowledged, so the sender retransmits them
+    void attach_memory_pool(std::shared_ptr<ReassemblyMemoryPool> pool);
+
+    //! \returns the total out-of-order bytes the memory pool has pruned from this reassembler
+    uint64_t pruned_bytes() const { return _pruned_bytes; }
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
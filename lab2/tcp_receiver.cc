@@ -1,5 +1,10 @@
 #include "tcp_receiver.hh"
 
+#include "tcp_config.hh"
+
+#include <algorithm>
+#include <string_view>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -10,9 +15,23 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+//! \param[in] capacity the maximum number of bytes that the receiver will store in its buffers
+TCPReceiver::TCPReceiver(const size_t capacity)
+    : _reassembler(capacity)
+    , _capacity(capacity)
+    , _window_shift(0)
+    , _initial_capacity(capacity)
+    , _target_capacity(capacity) {
+    while ((_window_shift < 14) && ((_capacity >> _window_shift) > UINT16_MAX)) {
+        ++_window_shift;
+    }
+}
+
 void TCPReceiver::segment_received(const TCPSegment &seg) {
-    TCPHeader header = seg.header();
-    Buffer data = seg.payload();
+    const TCPHeader &header = seg.header();
+    if (_stats) {
+        _stats->segment_received(seg.payload().size());
+    }
     /* LISTEN 处理流程 */
     if (!_isn.has_value()) {
         if (!header.syn)
@@ -20,18 +39,252 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         _isn = header.seqno;
     }
     /* SYN_RECV 处理流程 */
+    uint64_t ackno_before = header.syn ? 0 : abs_ackno();
+    size_t unassembled_before = unassembled_bytes();
+    _reassembler.push_substring(seg.payload().str(), stream_index(header), header.fin); // FIN_RECV 隐含在push_string中
+    if (_stats) {
+        _stats->unassembled_bytes(unassembled_bytes());
+        _stats->out_of_order_pruned(_reassembler.pruned_bytes() - _pruned_reported);
+        _pruned_reported = _reassembler.pruned_bytes();
+    }
+    autotune(true);
+
+    /* 不占用序号空间的segment(纯ACK)无需确认 */
+    if (seg.length_in_sequence_space() == 0) {
+        return;
+    }
+    schedule_ack(ackno_before, unassembled_before, header.syn || header.fin);
+}
+
+//! \details 批内的segment先按LISTEN状态的规则过滤(SYN之前到达的segment被丢弃)，
+//! 再按流中的位置排序：被之前的片段完全覆盖的重复数据直接跳过，其余的按序推入重组器。
+//! 批内乱序到达的片段因此都落在按序写入的快速路径上，payload只从segment拷贝一次到输出流。
+void TCPReceiver::segments_received(const vector<TCPSegment> &segments) {
+    struct Piece {
+        uint64_t index;
+        string_view data;
+        bool fin;
+    };
+    vector<Piece> pieces;
+    pieces.reserve(segments.size());
+    uint64_t ackno_before = _isn.has_value() ? abs_ackno() : 0;
+    size_t unassembled_before = unassembled_bytes();
+    bool occupies_sequence_space = false;
+    bool urgent = false;
+
+    for (const TCPSegment &seg : segments) {
+        const TCPHeader &header = seg.header();
+        if (_stats) {
+            _stats->segment_received(seg.payload().size());
+        }
+        if (!_isn.has_value()) {
+            if (!header.syn) {
+                continue;
+            }
+            _isn = header.seqno;
+        }
+        pieces.push_back({stream_index(header), seg.payload().str(), header.fin});
+        occupies_sequence_space |= (seg.length_in_sequence_space() > 0);
+        urgent |= (header.syn || header.fin);
+    }
+    if (pieces.empty()) {
+        return;
+    }
+
+    /* 起点相同时较长的片段在前，其后被它覆盖的片段都会被跳过 */
+    const auto stream_order = [](const Piece &a, const Piece &b) {
+        return (a.index < b.index) || ((a.index == b.index) && (a.data.size() > b.data.size()));
+    };
+    if (!is_sorted(pieces.begin(), pieces.end(), stream_order)) {
+        sort(pieces.begin(), pieces.end(), stream_order);
+    }
+    uint64_t covered_end = 0;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        const Piece &piece = pieces[i];
+        uint64_t end = piece.index + piece.data.size();
+        if ((i > 0) && (end <= covered_end) && !piece.fin) {
+            continue;
+        }
+        _reassembler.push_substring(piece.data, piece.index, piece.fin);
+        covered_end = max(covered_end, end);
+    }
+    if (_stats) {
+        _stats->unassembled_bytes(unassembled_bytes());
+        _stats->out_of_order_pruned(_reassembler.pruned_bytes() - _pruned_reported);
+        _pruned_reported = _reassembler.pruned_bytes();
+    }
+    autotune(true);
+
+    if (occupies_sequence_space) {
+        schedule_ack(ackno_before, unassembled_before, urgent);
+    }
+}
+
+//! \details 流中index为i的字节的绝对序号为i+1(SYN占用序号0)，以最后一个已重组的字节为unwrap的检查点
+uint64_t TCPReceiver::stream_index(const TCPHeader &header) const {
     uint64_t last_reassembled_index = stream_out().bytes_read() + stream_out().buffer_size();
-    size_t stream_index = unwrap(header.seqno, _isn.value(), last_reassembled_index) - (header.syn ? 0 : 1);
-    _reassembler.push_substring(data.copy(), stream_index, header.fin); // FIN_RECV 隐含在push_string中
+    return unwrap(header.seqno, _isn.value(), last_reassembled_index) - (header.syn ? 0 : 1);
+}
+
+void TCPReceiver::schedule_ack(const uint64_t ackno_before, const size_t unassembled_before, const bool urgent) {
+    if (!_delayed_ack_ms.has_value()) {
+        _ack_pending = true;
+        return;
+    }
+    /**
+     * 延迟ACK策略：乱序或重复的数据、填补了空洞的数据以及SYN/FIN需要立即确认；
+     * 按序到达的数据每累计两个满segment确认一次，否则启动延迟ACK计时器。
+     */
+    uint64_t ackno_after = abs_ackno();
+    if ((ackno_after <= ackno_before) || (unassembled_before > 0) || urgent) {
+        _ack_pending = true;
+        return;
+    }
+    _unacked_bytes += ackno_after - ackno_before;
+    if (_unacked_bytes >= 2 * TCPConfig::MAX_PAYLOAD_SIZE) {
+        _ack_pending = true;
+    } else if (!_delayed_ack_elapsed.has_value()) {
+        _delayed_ack_elapsed = 0;
+    }
 } 
 
+uint64_t TCPReceiver::abs_ackno() const {
+    const ByteStream &inbound = stream_out();
+    return inbound.bytes_written() + 1 + (inbound.input_ended() ? 1 : 0);
+}
+
 optional<WrappingInt32> TCPReceiver::ackno() const { 
     if (_isn.has_value()) {
-        ByteStream inbound = stream_out();
-        uint64_t abs_seqno = inbound.bytes_read() + inbound.buffer_size() + 1 + (inbound.input_ended() ? 1 : 0);
-        return wrap(abs_seqno, _isn.value());
+        return wrap(abs_ackno(), _isn.value());
     }
     return nullopt;
 }
 
+//! \param[in] delay_ms the longest an ACK for in-order data may be held back
+void TCPReceiver::enable_delayed_ack(const size_t delay_ms) { _delayed_ack_ms = delay_ms; }
+
+//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
+void TCPReceiver::tick(const size_t ms_since_last_tick) {
+    if (_delayed_ack_elapsed.has_value()) {
+        _delayed_ack_elapsed = _delayed_ack_elapsed.value() + ms_since_last_tick;
+        _ack_pending |= (_delayed_ack_elapsed.value() >= _delayed_ack_ms.value_or(0));
+    }
+    _time_ms += ms_since_last_tick;
+    autotune(false);
+}
+
+//! \param[in] max_capacity the largest capacity autotuning may grow to
+//! \param[in] idle_ms how long the connection must be idle before the capacity falls back
+void TCPReceiver::enable_autotuning(const size_t max_capacity, const size_t idle_ms) {
+    _max_capacity = max(max_capacity, _initial_capacity);
+    _idle_shrink_ms = idle_ms;
+    _window_shift = 0;
+    while ((_window_shift < 14) && ((_max_capacity.value() >> _window_shift) > UINT16_MAX)) {
+        ++_window_shift;
+    }
+}
+
+/**
+ * 接收窗口自动调整，做法与Linux的tcp_rcv_space_adjust相同(DRS，动态右边界)：
+ * 1. RTT估计：记下当前窗口右边界，收到的数据越过它时，所用时间即一个RTT的样本。
+ *    样本包含发送方没有数据可发的时间，只会偏大，因此估计值随较小的样本立即下降、随较大的样本缓慢上升。
+ * 2. 每个RTT统计应用读出的字节数copied，超过以往的最大值时，容量增长到2*copied(发送方的窗口每个RTT
+ *    可能翻倍)加上16个MSS的余量，读出速率增长越快，额外的增量越大。
+ * 3. 空闲(没有数据到达、被读出或缓存)达到设定时间后，目标容量回落到初始容量；流结束后只做这一步。
+ * 容量不低于已通告的窗口右边界所需的容量，即已通告的窗口不会回缩：缩小时随着数据到达逐步达到目标容量。
+ */
+void TCPReceiver::autotune(const bool received) {
+    if (!_max_capacity.has_value() || !_isn.has_value()) {
+        return;
+    }
+    const ByteStream &inbound = stream_out();
+    /* 流结束后不再有数据到达，只需在空闲后回落 */
+    bool growing = !inbound.input_ended();
+    uint64_t bytes_read = inbound.bytes_read();
+    if (received || (bytes_read != _last_bytes_read) || (inbound.buffer_size() > 0)) {
+        _last_active_ms = _time_ms;
+        _last_bytes_read = bytes_read;
+    }
+
+    if (received && growing) {
+        if (_rtt_measurement.has_value() && (inbound.bytes_written() >= _rtt_measurement->first)) {
+            uint64_t sample = max<uint64_t>(_time_ms - _rtt_measurement->second, 1);
+            bool lower = !_rtt_ms.has_value() || (sample < _rtt_ms.value());
+            _rtt_ms = lower ? sample : (7 * _rtt_ms.value() + sample) / 8;
+            _rtt_measurement = nullopt;
+        }
+        if (!_rtt_measurement.has_value()) {
+            _rtt_measurement = make_pair(inbound.bytes_written() + window_size(), _time_ms);
+        }
+    }
+
+    if (growing && _rtt_ms.has_value() && (_time_ms - _space_start_ms >= _rtt_ms.value())) {
+        uint64_t copied = bytes_read - _space_start_read;
+        if (copied > _space) {
+            uint64_t rcvwin = 2 * copied + 16 * TCPConfig::MAX_PAYLOAD_SIZE;
+            if (_space > 0) {
+                rcvwin += 2 * rcvwin * (copied - _space) / _space;
+            }
+            _target_capacity = max<uint64_t>(_target_capacity, min<uint64_t>(rcvwin, _max_capacity.value()));
+            _space = copied;
+        }
+        _space_start_ms = _time_ms;
+        _space_start_read = bytes_read;
+    }
+
+    bool idle = (_time_ms > _last_active_ms) && (_time_ms - _last_active_ms >= _idle_shrink_ms);
+    if (idle && (_target_capacity > _initial_capacity)) {
+        _target_capacity = _initial_capacity;
+        _space = 0;
+        _rtt_measurement = nullopt;
+    }
+
+    /* 尚未通告过窗口时不知道对方可能发送到哪里，只增不减；流结束后对方不会再发送数据，无需保留已通告的窗口 */
+    size_t capacity = growing ? max(_target_capacity, _capacity) : _target_capacity;
+    if (growing && (_advertised_right_edge > 0)) {
+        uint64_t advertised = _advertised_right_edge - 1;
+        capacity = max<uint64_t>(_target_capacity, (advertised > bytes_read) ? advertised - bytes_read : 0);
+    }
+    if (capacity != _capacity) {
+        _capacity = _reassembler.set_capacity(capacity);
+    }
+}
+
+//! \details 除了待发送的ACK外，当应用读取数据使窗口右边界比上次通告的右边界
+//! 前进了至少min(2*MSS, capacity/2)时，也需要发送窗口更新(RFC 1122的接收方SWS避免)
+bool TCPReceiver::ack_needed() const {
+    if (!_isn.has_value()) {
+        return false;
+    }
+    uint64_t window_right_edge = abs_ackno() + window_size();
+    uint64_t threshold = min<uint64_t>(2 * TCPConfig::MAX_PAYLOAD_SIZE, _capacity / 2);
+    return _ack_pending || (window_right_edge >= _advertised_right_edge + max<uint64_t>(threshold, 1));
+}
+
+void TCPReceiver::ack_sent() {
+    _ack_pending = false;
+    _unacked_bytes = 0;
+    _delayed_ack_elapsed = nullopt;
+    if (_isn.has_value()) {
+        _advertised_right_edge = abs_ackno() + window_size();
+    }
+}
+
+//! \details 流中index为i的字节的绝对序号为i+1(SYN占用序号0)
+vector<SackBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<SackBlock> blocks;
+    if (!_isn.has_value()) {
+        return blocks;
+    }
+    for (const auto &range : _reassembler.unassembled_ranges(max_blocks)) {
+        blocks.push_back({wrap(range.first + 1, _isn.value()), wrap(range.second + 1, _isn.value())});
+    }
+    return blocks;
+}
+
 size_t TCPReceiver::window_size() const { return _capacity - stream_out().buffer_size(); }
+
+uint16_t TCPReceiver::window_field() const {
+    size_t window = window_size() >> (_window_scaling ? _window_shift : 0);
+    return static_cast<uint16_t>(min<size_t>(window, UINT16_MAX));
+}
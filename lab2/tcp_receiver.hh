@@ -3,10 +3,15 @@
 
 #include "byte_stream.hh"
 #include "stream_reassembler.hh"
+#include "tcp_sack.hh"
 #include "tcp_segment.hh"
+#include "tcp_stats.hh"
 #include "wrapping_integers.hh"
 
+#include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -21,13 +26,76 @@ class TCPReceiver {
     size_t _capacity;
     std::optional<WrappingInt32> _isn{};
 
+    // 延迟ACK的最长时间，为空时每个占用序号空间的segment都需要立即确认
+    std::optional<size_t> _delayed_ack_ms{};
+
+    // 延迟ACK计时器已经过的时间，计时器未启动时为空
+    std::optional<size_t> _delayed_ack_elapsed{};
+
+    // 是否有需要立即发送的ACK
+    bool _ack_pending{false};
+
+    // 上次发送ACK以来按序接收但尚未确认的字节数
+    uint64_t _unacked_bytes{0};
+
+    // 上次发送ACK时通告的窗口右边界(绝对序号)
+    uint64_t _advertised_right_edge{0};
+
+    // 下一个期望接收的绝对序号
+    uint64_t abs_ackno() const;
+
+    // segment的payload在流中的index(SYN占用序号0，payload从序号1开始)
+    uint64_t stream_index(const TCPHeader &header) const;
+
+    // 处理完占用序号空间的数据后，按ACK策略决定立即确认还是延迟确认；urgent表示含有SYN/FIN
+    void schedule_ack(const uint64_t ackno_before, const size_t unassembled_before, const bool urgent);
+
+    // 窗口缩放位数(RFC 7323)：在SYN中提议，双方都提议时生效
+    uint8_t _window_shift;
+    bool _window_scaling{false};
+
+    // 连接的统计计数器，与发送方共享，为空时不统计
+    std::shared_ptr<TCPStats> _stats{};
+
+    // 已计入统计的被内存池修剪的乱序字节数：修剪可能发生在其他连接收到segment时，在本连接下次收到segment时计入
+    uint64_t _pruned_reported{0};
+
+    // 接收窗口自动调整(类似Linux的tcp_rmem自动调整)：容量上限，为空时不调整；
+    // 空闲_idle_shrink_ms后目标容量回落到构造时的初始容量
+    std::optional<size_t> _max_capacity{};
+    size_t _initial_capacity;
+    size_t _idle_shrink_ms{0};
+
+    // 目标容量：实际容量不低于它，也不低于已通告的窗口右边界所需的容量(窗口不回缩)
+    size_t _target_capacity;
+
+    // 由tick累计的时间(ms)
+    uint64_t _time_ms{0};
+
+    // 接收方的RTT估计：从开始测量到收完当时的一个窗口的数据所用的时间，
+    // 正在进行的测量为(需要收到的流index, 开始时刻)
+    std::optional<uint64_t> _rtt_ms{};
+    std::optional<std::pair<uint64_t, uint64_t>> _rtt_measurement{};
+
+    // 每个RTT应用读出的字节数：本轮的开始时刻与开始时的累计读出字节数，以及已测得的最大值
+    uint64_t _space_start_ms{0};
+    uint64_t _space_start_read{0};
+    uint64_t _space{0};
+
+    // 最后一次有数据到达、被读出或仍在缓存中的时刻
+    uint64_t _last_active_ms{0};
+    uint64_t _last_bytes_read{0};
+
+    // 测量RTT与读出速率，据此调整目标容量并应用到重组器与输出流；received表示刚收到了segment
+    void autotune(const bool received);
+
 
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    TCPReceiver(const size_t capacity);
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -50,6 +118,26 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \name Window scaling (RFC 7323)
+    //!@{
+
+    //! \brief The window scale shift to offer in our SYN: the smallest shift (at most 14)
+    //! that lets the whole capacity be advertised in 16 bits
+    uint8_t window_shift() const { return _window_shift; }
+
+    //! \brief Whether the peer also offered window scaling, so that our offered shift applies
+    void set_window_scaling(const bool negotiated) { _window_scaling = negotiated; }
+
+    //! \brief The value for the 16-bit window field: window_size() shifted right by the
+    //! negotiated shift, rounded down so we never advertise more than we can hold
+    uint16_t window_field() const;
+    //!@}
+
+    //! \brief SACK blocks describing the out-of-order data the receiver holds
+    //! \param max_blocks at most this many blocks are returned
+    //! \returns blocks in ascending seqno order; empty if no SYN has been received
+    std::vector<SackBlock> sack_blocks(const size_t max_blocks = 4) const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
@@ -58,6 +146,54 @@ class TCPReceiver {
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
+    //! \brief handle a batch of inbound segments for this connection (e.g. one NIC receive batch)
+    //!
+    //! Equivalent to calling segment_received() on each segment in turn, except that the payloads
+    //! are pushed in stream order with duplicates dropped, so out-of-order arrivals within the batch
+    //! take the in-order path instead of being stored and reassembled, and the ACK policy runs once
+    //! for the whole batch.
+    void segments_received(const std::vector<TCPSegment> &segments);
+
+    //! \name ACK policy for the connection that owns this receiver
+    //!@{
+
+    //! \brief Hold back ACKs for in-order data: ack every second full segment, or after `delay_ms`
+    //! \note Out-of-order data, data that fills a gap, SYN and FIN are still acked at once
+    void enable_delayed_ack(const size_t delay_ms = 40);
+
+    //! \brief Notifies the TCPReceiver of the passage of time (drives the delayed-ACK timer)
+    void tick(const size_t ms_since_last_tick);
+
+    //! \brief Whether an ACK (or a window update) should be sent now
+    bool ack_needed() const;
+
+    //! \brief Record that an ACK carrying the current ackno() and window_size() was sent
+    void ack_sent();
+    //!@}
+
+    //! \name Receive-window autotuning
+    //!@{
+
+    //! \brief Size the buffers from how fast the application reads: once per RTT (estimated from the
+    //! time it takes to receive a full window), grow the capacity to twice the bytes read in that RTT,
+    //! up to `max_capacity`; after `idle_ms` with nothing received or read, fall back to the initial capacity
+    //! \note Call before window_shift() is offered in the SYN, which is then chosen for `max_capacity`.
+    //! Shrinking relies on ack_sent() being called for every ACK, and never retracts the advertised window:
+    //! the window closes as data arrives until the smaller capacity is reached.
+    void enable_autotuning(const size_t max_capacity, const size_t idle_ms = 1000);
+
+    //! \brief The current capacity (the constructor's, unless autotuning is enabled)
+    size_t capacity() const { return _capacity; }
+    //!@}
+
+    //! \brief Charge out-of-order bytes to a pool shared with other connections (see ReassemblyMemoryPool)
+    void attach_memory_pool(std::shared_ptr<ReassemblyMemoryPool> pool) {
+        _reassembler.attach_memory_pool(std::move(pool));
+    }
+
+    //! \brief Count received segments and out-of-order bytes in `stats` (shared with the TCPSender)
+    void set_stats(std::shared_ptr<TCPStats> stats) { _stats = std::move(stats); }
+
     //! \name "Output" interface for the reader
     //!@{
     ByteStream &stream_out() { return _reassembler.stream_out(); }
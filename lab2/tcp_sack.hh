@@ -0,0 +1,15 @@
+#ifndef SPONGE_LIBSPONGE_TCP_SACK_HH
+#define SPONGE_LIBSPONGE_TCP_SACK_HH
+
+#include "wrapping_integers.hh"
+
+//! \brief A selective acknowledgment block (RFC 2018)
+
+//! The receiver holds every byte in [left, right), but not the byte
+//! just before `left`, so the sender need not retransmit this range.
+struct SackBlock {
+    WrappingInt32 left;   //!< seqno of the first byte held
+    WrappingInt32 right;  //!< seqno just past the last byte held
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_SACK_HH
@@ -0,0 +1,102 @@
+#ifndef SPONGE_LIBSPONGE_TCP_STATS_HH
+#define SPONGE_LIBSPONGE_TCP_STATS_HH
+
+#include <atomic>
+#include <cstdint>
+
+//! \brief A point-in-time copy of a connection's TCPStats
+struct TCPStatsSnapshot {
+    uint64_t segments_sent{0};          //!< segments handed to segments_out(), retransmissions included
+    uint64_t bytes_sent{0};             //!< payload bytes in those segments
+    uint64_t segments_received{0};      //!< segments passed to TCPReceiver::segment_received()
+    uint64_t bytes_received{0};         //!< payload bytes in those segments
+    uint64_t rto_retransmissions{0};    //!< segments resent because the timer expired
+    uint64_t fast_retransmissions{0};   //!< segments resent on duplicate ACKs, partial ACKs or SACK loss detection
+    uint64_t lost_retransmissions{0};   //!< segments marked lost (timeout, SACK or reneging) and resent within cwnd
+    uint64_t duplicate_acks{0};         //!< ACKs that acknowledged nothing new while data was outstanding
+    uint64_t peak_unassembled_bytes{0}; //!< high-water mark of the receiver's out-of-order bytes
+    uint64_t ofo_pruned_bytes{0};       //!< out-of-order bytes dropped by a shared ReassemblyMemoryPool
+    uint64_t zero_window_events{0};     //!< times the peer's advertised window dropped to zero
+    uint64_t window_limited_ms{0};      //!< time with data to send but no room in the window
+    uint64_t app_limited_ms{0};         //!< time with room in the window but nothing to send
+    uint64_t pacing_limited_ms{0};      //!< time with data and room in the window, held back by pacing
+};
+
+//! \brief Counters for one connection, shared by its TCPSender and TCPReceiver
+
+//! Each counter has a single writer (the thread running the connection), which
+//! updates it with relaxed loads and stores instead of locked read-modify-writes.
+//! Any other thread may call snapshot() at any time; each field is read atomically,
+//! but the snapshot as a whole is not a consistent cut across fields.
+class TCPStats {
+  private:
+    std::atomic<uint64_t> _segments_sent{0};
+    std::atomic<uint64_t> _bytes_sent{0};
+    std::atomic<uint64_t> _segments_received{0};
+    std::atomic<uint64_t> _bytes_received{0};
+    std::atomic<uint64_t> _rto_retransmissions{0};
+    std::atomic<uint64_t> _fast_retransmissions{0};
+    std::atomic<uint64_t> _lost_retransmissions{0};
+    std::atomic<uint64_t> _duplicate_acks{0};
+    std::atomic<uint64_t> _peak_unassembled_bytes{0};
+    std::atomic<uint64_t> _ofo_pruned_bytes{0};
+    std::atomic<uint64_t> _zero_window_events{0};
+    std::atomic<uint64_t> _window_limited_ms{0};
+    std::atomic<uint64_t> _app_limited_ms{0};
+    std::atomic<uint64_t> _pacing_limited_ms{0};
+
+    static void add(std::atomic<uint64_t> &counter, const uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static void raise_to(std::atomic<uint64_t> &counter, const uint64_t value) {
+        if (value > counter.load(std::memory_order_relaxed)) {
+            counter.store(value, std::memory_order_relaxed);
+        }
+    }
+
+  public:
+    //! \name Updates (connection thread only)
+    //!@{
+    void segment_sent(const uint64_t payload_bytes) {
+        add(_segments_sent, 1);
+        add(_bytes_sent, payload_bytes);
+    }
+    void segment_received(const uint64_t payload_bytes) {
+        add(_segments_received, 1);
+        add(_bytes_received, payload_bytes);
+    }
+    void rto_retransmission() { add(_rto_retransmissions, 1); }
+    void fast_retransmission() { add(_fast_retransmissions, 1); }
+    void lost_retransmission() { add(_lost_retransmissions, 1); }
+    void duplicate_ack() { add(_duplicate_acks, 1); }
+    void unassembled_bytes(const uint64_t bytes) { raise_to(_peak_unassembled_bytes, bytes); }
+    void out_of_order_pruned(const uint64_t bytes) { add(_ofo_pruned_bytes, bytes); }
+    void zero_window() { add(_zero_window_events, 1); }
+    void window_limited(const uint64_t ms) { add(_window_limited_ms, ms); }
+    void app_limited(const uint64_t ms) { add(_app_limited_ms, ms); }
+    void pacing_limited(const uint64_t ms) { add(_pacing_limited_ms, ms); }
+    //!@}
+
+    //! \brief Copy every counter (safe from any thread)
+    TCPStatsSnapshot snapshot() const {
+        TCPStatsSnapshot snapshot;
+        snapshot.segments_sent = _segments_sent.load(std::memory_order_relaxed);
+        snapshot.bytes_sent = _bytes_sent.load(std::memory_order_relaxed);
+        snapshot.segments_received = _segments_received.load(std::memory_order_relaxed);
+        snapshot.bytes_received = _bytes_received.load(std::memory_order_relaxed);
+        snapshot.rto_retransmissions = _rto_retransmissions.load(std::memory_order_relaxed);
+        snapshot.fast_retransmissions = _fast_retransmissions.load(std::memory_order_relaxed);
+        snapshot.lost_retransmissions = _lost_retransmissions.load(std::memory_order_relaxed);
+        snapshot.duplicate_acks = _duplicate_acks.load(std::memory_order_relaxed);
+        snapshot.peak_unassembled_bytes = _peak_unassembled_bytes.load(std::memory_order_relaxed);
+        snapshot.ofo_pruned_bytes = _ofo_pruned_bytes.load(std::memory_order_relaxed);
+        snapshot.zero_window_events = _zero_window_events.load(std::memory_order_relaxed);
+        snapshot.window_limited_ms = _window_limited_ms.load(std::memory_order_relaxed);
+        snapshot.app_limited_ms = _app_limited_ms.load(std::memory_order_relaxed);
+        snapshot.pacing_limited_ms = _pacing_limited_ms.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_STATS_HH
@@ -0,0 +1,183 @@
+#include "congestion_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+
+NewRenoController::NewRenoController(const uint64_t mss, const uint64_t initial_cwnd_segments)
+    : _mss(mss), _cwnd(mss * initial_cwnd_segments), _ssthresh(UINT64_MAX) {}
+
+/**
+ * NewRenoController::on_ack : 慢启动阶段cwnd增加min(确认字节数, MSS)，
+ * 拥塞避免阶段每确认一个cwnd的数据cwnd增加一个MSS。
+ */
+void NewRenoController::on_ack(const AckEvent &event) {
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(event.acked_bytes, _mss);
+        return;
+    }
+    _acked_in_avoidance += event.acked_bytes;
+    if (_acked_in_avoidance >= _cwnd) {
+        _acked_in_avoidance -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+/**
+ * NewRenoController::on_loss : ssthresh设为在途字节数的一半，cwnd降至ssthresh。
+ */
+void NewRenoController::on_loss(const uint64_t /* now_ms */, const uint64_t bytes_in_flight) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _ssthresh;
+    _acked_in_avoidance = 0;
+}
+
+/**
+ * NewRenoController::on_timeout : ssthresh设为在途字节数的一半，cwnd回到一个MSS重新慢启动。
+ */
+void NewRenoController::on_timeout(const uint64_t /* now_ms */, const uint64_t bytes_in_flight) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _mss;
+    _acked_in_avoidance = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CubicController::CubicController(const uint64_t mss, const uint64_t initial_cwnd_segments)
+    : _mss(mss), _cwnd(mss * initial_cwnd_segments), _ssthresh(UINT64_MAX) {}
+
+/**
+ * CubicController::on_ack : 慢启动阶段与Reno相同；拥塞避免阶段向三次函数给出的
+ * 下一个RTT后的目标窗口增长，且不低于Reno的估计窗口。
+ */
+void CubicController::on_ack(const AckEvent &event) {
+    if (event.rtt_ms.has_value() && (_min_rtt_ms == 0 || event.rtt_ms.value() < _min_rtt_ms)) {
+        _min_rtt_ms = event.rtt_ms.value();
+    }
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(event.acked_bytes, _mss);
+        return;
+    }
+
+    /* 新的拥塞避免阶段开始 */
+    if (!_epoch_start_ms.has_value()) {
+        _epoch_start_ms = event.now_ms;
+        if (_cwnd < _w_max) {
+            _k = cbrt((_w_max - _cwnd) / _mss / C);
+        } else {
+            _k = 0;
+            _w_max = _cwnd;
+        }
+        _w_est = _cwnd;
+    }
+
+    double t = (event.now_ms - _epoch_start_ms.value() + _min_rtt_ms) / 1000.0;
+    double target = C * pow(t - _k, 3) * _mss + _w_max;
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * _mss * event.acked_bytes / _cwnd;
+
+    if (target > _cwnd) {
+        _cwnd += static_cast<uint64_t>((target - _cwnd) * event.acked_bytes / _cwnd);
+    }
+    _cwnd = max(_cwnd, static_cast<uint64_t>(_w_est));
+}
+
+/**
+ * CubicController::reduce : 记录W_max(快速收敛：窗口仍在下降时进一步减小W_max)，
+ * 并将ssthresh设为 BETA * cwnd。
+ */
+void CubicController::reduce(const uint64_t /* bytes_in_flight */) {
+    _w_max = (_cwnd < _w_max) ? _cwnd * (1 + BETA) / 2 : _cwnd;
+    _ssthresh = max(static_cast<uint64_t>(_cwnd * BETA), 2 * _mss);
+    _epoch_start_ms = nullopt;
+}
+
+void CubicController::on_loss(const uint64_t /* now_ms */, const uint64_t bytes_in_flight) {
+    reduce(bytes_in_flight);
+    _cwnd = _ssthresh;
+}
+
+void CubicController::on_timeout(const uint64_t /* now_ms */, const uint64_t bytes_in_flight) {
+    reduce(bytes_in_flight);
+    _cwnd = _mss;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BBRController::BBRController(const uint64_t mss, const uint64_t initial_cwnd_segments)
+    : _mss(mss), _cwnd(mss * initial_cwnd_segments) {}
+
+/**
+ * BBRController::on_ack : 更新最小RTT；每经过一个最小RTT结束一轮，
+ * 以该轮的投递速率更新瓶颈带宽估计，并判断STARTUP阶段是否已填满管道。
+ */
+void BBRController::on_ack(const AckEvent &event) {
+    _delivered += event.acked_bytes;
+
+    if (event.rtt_ms.has_value() &&
+        (!_min_rtt_ms.has_value() || event.rtt_ms.value() <= _min_rtt_ms.value() ||
+         event.now_ms - _min_rtt_stamp_ms > MIN_RTT_WINDOW_MS)) {
+        _min_rtt_ms = max<uint64_t>(event.rtt_ms.value(), 1);
+        _min_rtt_stamp_ms = event.now_ms;
+    }
+
+    if (_min_rtt_ms.has_value() && event.now_ms - _round_start_ms >= _min_rtt_ms.value()) {
+        double rate = static_cast<double>(_delivered - _round_start_delivered) / (event.now_ms - _round_start_ms);
+        ++_round;
+        _round_start_ms = event.now_ms;
+        _round_start_delivered = _delivered;
+
+        /* 近似的窗口最大值滤波：更大的样本或旧的估计过期时更新 */
+        if (rate >= _btl_bw || _round - _btl_bw_round >= BW_WINDOW_ROUNDS) {
+            _btl_bw = rate;
+            _btl_bw_round = _round;
+        }
+
+        if (_startup) {
+            if (_btl_bw >= _full_bw * 1.25) {
+                _full_bw = _btl_bw;
+                _full_bw_rounds = 0;
+            } else if (++_full_bw_rounds >= 3) {
+                _startup = false;
+            }
+        }
+    }
+
+    _cwnd += event.acked_bytes;
+    if (_btl_bw > 0 && _min_rtt_ms.has_value()) {
+        update_cwnd();
+    }
+}
+
+/**
+ * BBRController::update_cwnd : 拥塞窗口不超过 gain * BDP(STARTUP阶段使用更大的增益)，且至少为4个MSS。
+ */
+void BBRController::update_cwnd() {
+    double bdp = _btl_bw * _min_rtt_ms.value();
+    double gain = _startup ? STARTUP_GAIN : CWND_GAIN;
+    _cwnd = min(_cwnd, static_cast<uint64_t>(gain * bdp));
+    _cwnd = max(_cwnd, 4 * _mss);
+}
+
+/**
+ * BBRController::on_loss : BBR不以丢包作为拥塞信号，窗口由模型决定。
+ */
+void BBRController::on_loss(const uint64_t /* now_ms */, const uint64_t /* bytes_in_flight */) {}
+
+/**
+ * BBRController::on_timeout : 超时后窗口回到一个MSS，之后按模型重新增长。
+ */
+void BBRController::on_timeout(const uint64_t /* now_ms */, const uint64_t /* bytes_in_flight */) { _cwnd = _mss; }
+
+/**
+ * BBRController::pacing_rate : 以带宽估计乘以增益作为发送速率(STARTUP阶段与拥塞窗口使用相同的增益)，
+ * 尚无带宽估计时为空。
+ */
+optional<double> BBRController::pacing_rate() const {
+    if (_btl_bw <= 0) {
+        return nullopt;
+    }
+    return _btl_bw * (_startup ? STARTUP_GAIN : PACING_GAIN);
+}
@@ -0,0 +1,171 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * 一次确认了新数据的ACK所携带的信息
+ */
+struct AckEvent {
+  // 自发送方创建以来流逝的时间(ms)
+  uint64_t now_ms{0};
+
+  // 此次ACK新确认的字节数(序号空间)
+  uint64_t acked_bytes{0};
+
+  // 处理此次ACK后仍未被确认的字节数
+  uint64_t bytes_in_flight{0};
+
+  // 此次ACK得到的RTT样本，被确认的segment若经过重传则没有样本(Karn算法)
+  std::optional<uint64_t> rtt_ms{};
+};
+
+/**
+ * 拥塞控制算法接口，TCPSender在收到ACK、检测到丢包以及超时重传时通知拥塞控制算法，
+ * 并以 min(cwnd, rwnd) 作为实际的发送窗口。
+ */
+class CongestionController {
+public:
+  virtual ~CongestionController() = default;
+
+  // 收到确认了新数据的ACK
+  virtual void on_ack(const AckEvent &event) = 0;
+
+  // 检测到丢包(如收到重复ACK)，但尚未超时
+  virtual void on_loss(const uint64_t now_ms, const uint64_t bytes_in_flight) = 0;
+
+  // 重传计时器超时
+  virtual void on_timeout(const uint64_t now_ms, const uint64_t bytes_in_flight) = 0;
+
+  // 拥塞窗口(字节)
+  virtual uint64_t cwnd() const = 0;
+
+  // 慢启动阈值(字节)
+  virtual uint64_t ssthresh() const = 0;
+
+  // 算法自身给出的发送速率(字节/ms)，供发送方的pacing使用；为空时发送方由 cwnd/SRTT 计算
+  virtual std::optional<double> pacing_rate() const { return std::nullopt; }
+};
+
+/**
+ * NewReno：慢启动时每确认一个字节cwnd增加一个字节，拥塞避免时每个RTT增加一个MSS，
+ * 丢包时cwnd减半，超时时cwnd回到一个MSS。
+ */
+class NewRenoController : public CongestionController {
+private:
+  uint64_t _mss;
+  uint64_t _cwnd;
+  uint64_t _ssthresh;
+
+  // 拥塞避免阶段累计的确认字节数，满一个cwnd时cwnd增加一个MSS
+  uint64_t _acked_in_avoidance{0};
+
+public:
+  NewRenoController(const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE, const uint64_t initial_cwnd_segments = 10);
+
+  void on_ack(const AckEvent &event) override;
+  void on_loss(const uint64_t now_ms, const uint64_t bytes_in_flight) override;
+  void on_timeout(const uint64_t now_ms, const uint64_t bytes_in_flight) override;
+  uint64_t cwnd() const override { return _cwnd; }
+  uint64_t ssthresh() const override { return _ssthresh; }
+};
+
+/**
+ * CUBIC(RFC 8312)：拥塞避免阶段cwnd按 W(t) = C*(t-K)^3 + W_max 增长，
+ * 并以Reno的估计值作为下限(TCP友好区间)。
+ */
+class CubicController : public CongestionController {
+private:
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  uint64_t _mss;
+  uint64_t _cwnd;
+  uint64_t _ssthresh;
+
+  // 上一次丢包前的拥塞窗口(字节)
+  double _w_max{0};
+
+  // 当前拥塞避免阶段开始的时间及其对应的K值(秒)
+  std::optional<uint64_t> _epoch_start_ms{};
+  double _k{0};
+
+  // TCP友好区间内Reno的窗口估计(字节)
+  double _w_est{0};
+
+  // 最小RTT，用于预测下一个RTT后的目标窗口
+  uint64_t _min_rtt_ms{0};
+
+  // 丢包时记录W_max并计算新的窗口
+  void reduce(const uint64_t bytes_in_flight);
+
+public:
+  CubicController(const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE, const uint64_t initial_cwnd_segments = 10);
+
+  void on_ack(const AckEvent &event) override;
+  void on_loss(const uint64_t now_ms, const uint64_t bytes_in_flight) override;
+  void on_timeout(const uint64_t now_ms, const uint64_t bytes_in_flight) override;
+  uint64_t cwnd() const override { return _cwnd; }
+  uint64_t ssthresh() const override { return _ssthresh; }
+};
+
+/**
+ * 类BBR的基于模型的拥塞控制：估计瓶颈带宽(一段时间内投递速率的最大值)与最小RTT，
+ * 以 cwnd_gain * BDP 作为拥塞窗口；STARTUP阶段以较大增益探测带宽，
+ * 连续三轮带宽增长不足25%后进入稳定阶段。丢包不直接减小窗口。
+ */
+class BBRController : public CongestionController {
+private:
+  static constexpr double STARTUP_GAIN = 2.89;
+  static constexpr double CWND_GAIN = 2.0;
+  // 没有ProbeBW的增益循环，稳定阶段以略高于带宽估计的速率发送，使带宽增加时仍能被测到
+  static constexpr double PACING_GAIN = 1.25;
+  static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+  static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+
+  uint64_t _mss;
+  uint64_t _cwnd;
+
+  // 瓶颈带宽估计(字节/ms)及其所在的轮次
+  double _btl_bw{0};
+  uint64_t _btl_bw_round{0};
+
+  // 最小RTT估计及其采样时间
+  std::optional<uint64_t> _min_rtt_ms{};
+  uint64_t _min_rtt_stamp_ms{0};
+
+  // 轮次统计：每经过一个最小RTT为一轮，记录该轮开始时的时间与累计确认字节数
+  uint64_t _round{0};
+  uint64_t _round_start_ms{0};
+  uint64_t _delivered{0};
+  uint64_t _round_start_delivered{0};
+
+  // STARTUP阶段的状态
+  bool _startup{true};
+  double _full_bw{0};
+  unsigned int _full_bw_rounds{0};
+
+  // 以当前模型计算拥塞窗口
+  void update_cwnd();
+
+public:
+  BBRController(const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE, const uint64_t initial_cwnd_segments = 10);
+
+  void on_ack(const AckEvent &event) override;
+  void on_loss(const uint64_t now_ms, const uint64_t bytes_in_flight) override;
+  void on_timeout(const uint64_t now_ms, const uint64_t bytes_in_flight) override;
+  uint64_t cwnd() const override { return _cwnd; }
+  uint64_t ssthresh() const override { return _startup ? UINT64_MAX : _cwnd; }
+  std::optional<double> pacing_rate() const override;
+
+  // 瓶颈带宽估计(字节/ms)
+  double bottleneck_bandwidth() const { return _btl_bw; }
+
+  // 最小RTT估计(ms)
+  std::optional<uint64_t> min_rtt() const { return _min_rtt_ms; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
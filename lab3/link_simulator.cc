@@ -0,0 +1,185 @@
+#include "link_simulator.hh"
+
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+bool Link::chance(const double probability) {
+    if (probability <= 0.0) {
+        return false;
+    }
+    return uniform_real_distribution<double>(0.0, 1.0)(_rng) < probability;
+}
+
+//! \details 包先进入发送队列按带宽串行发送，发送完成后经传播时延(以及可能的乱序延迟)到达对端。
+//! 被随机丢弃的包仍然占用了链路带宽，只有队列溢出的包不会被发送。
+void Link::send(const uint64_t now_us, const size_t bytes, const Deliver &deliver) {
+    while (!_queue.empty() && _queue.front().first <= now_us) {
+        _queued_bytes -= _queue.front().second;
+        _queue.pop_front();
+    }
+    if (_config.queue_bytes > 0 && _queued_bytes + bytes > _config.queue_bytes) {
+        ++_dropped;
+        return;
+    }
+
+    uint64_t transmit_us = 0;
+    if (_config.bandwidth_bps > 0) {
+        transmit_us = (bytes * 8 * 1000000 + _config.bandwidth_bps - 1) / _config.bandwidth_bps;
+    }
+    _busy_until_us = max(now_us, _busy_until_us) + transmit_us;
+    if (transmit_us > 0) {
+        _queue.emplace_back(_busy_until_us, bytes);
+        _queued_bytes += bytes;
+    }
+
+    if (_bursting) {
+        _bursting = !chance(_config.burst_exit_rate);
+    } else {
+        _bursting = chance(_config.burst_enter_rate);
+    }
+    if (chance(_config.loss_rate) || (_bursting && chance(_config.burst_loss_rate))) {
+        ++_dropped;
+        return;
+    }
+
+    uint64_t arrival_us = _busy_until_us + _config.delay_ms * 1000;
+    if (chance(_config.reorder_rate)) {
+        arrival_us += _config.reorder_delay_ms * 1000;
+    }
+    _in_flight.emplace(make_pair(arrival_us, _next_packet++), deliver);
+    if (chance(_config.duplicate_rate)) {
+        _in_flight.emplace(make_pair(arrival_us, _next_packet++), deliver);
+    }
+}
+
+void Link::advance(const uint64_t now_us) {
+    while (!_in_flight.empty() && _in_flight.begin()->first.first <= now_us) {
+        Deliver deliver = move(_in_flight.begin()->second);
+        _in_flight.erase(_in_flight.begin());
+        deliver();
+    }
+}
+
+LinkSimulator::LinkSimulator(TCPSender &sender,
+                             TCPReceiver &receiver,
+                             const LinkConfig &forward,
+                             const LinkConfig &reverse,
+                             const uint64_t seed)
+    : _sender(sender), _receiver(receiver), _rng(seed), _forward(forward, _rng), _reverse(reverse, _rng) {}
+
+//! \details 起始序号低于已发送过的最大序号的segment记为一次重传
+void LinkSimulator::send_segments() {
+    _sender.fill_window();
+    while (!_sender.segments_out().empty()) {
+        const TCPSegment segment = move(_sender.segments_out().front());
+        _sender.segments_out().pop();
+
+        if (segment.header().syn && !_isn.has_value()) {
+            _isn = segment.header().seqno;
+        }
+        const uint64_t abs_seqno = unwrap(segment.header().seqno, _isn.value_or(segment.header().seqno), _highest_sent);
+        ++_report.segments_sent;
+        if (abs_seqno < _highest_sent) {
+            ++_report.retransmissions;
+        }
+        _highest_sent = max(_highest_sent, abs_seqno + segment.length_in_sequence_space());
+
+        _forward.send(_now_ms * 1000, HEADER_BYTES + segment.payload().size(), [this, segment]() {
+            _receiver.segment_received(segment);
+            send_ack();
+        });
+    }
+}
+
+void LinkSimulator::send_ack() {
+    const optional<WrappingInt32> ackno = _receiver.ackno();
+    if (!ackno.has_value() || !_receiver.ack_needed()) {
+        return;
+    }
+    const uint16_t window = _receiver.window_field();
+    const vector<SackBlock> sack_blocks = _sack ? _receiver.sack_blocks() : vector<SackBlock>{};
+    _receiver.ack_sent();
+    ++_report.acks_sent;
+
+    // 每个SACK块占8字节的TCP选项
+    _reverse.send(_now_ms * 1000, HEADER_BYTES + 8 * sack_blocks.size(), [this, ackno, window, sack_blocks]() {
+        _sender.ack_received(ackno.value(), window, sack_blocks);
+    });
+}
+
+TransferReport LinkSimulator::run(const size_t transfer_bytes, const uint64_t time_limit_ms) {
+    start(transfer_bytes, time_limit_ms);
+    while (!step()) {
+    }
+    return report();
+}
+
+void LinkSimulator::start(const size_t transfer_bytes, const uint64_t time_limit_ms) {
+    _transfer_bytes = transfer_bytes;
+    _time_limit_ms = _now_ms + time_limit_ms;
+    _chunk.assign(TCPConfig::MAX_PAYLOAD_SIZE, 'x');
+}
+
+//! \details 每一步(1ms)依次：应用写入数据、投递到达的包、发送方发送、应用读出数据、双方tick。
+//! 写入的数据以MSS为单位记录写入时刻，被读出时得到该段数据的端到端时延。
+bool LinkSimulator::step() {
+    if (_report.completed || (_now_ms > _time_limit_ms)) {
+        return true;
+    }
+    ByteStream &input = _sender.stream_in();
+    ByteStream &output = _receiver.stream_out();
+
+    while (_written < _transfer_bytes && input.remaining_capacity() > 0) {
+        _written += input.write(_chunk.substr(0, min(_chunk.size(), _transfer_bytes - _written)));
+        _write_times.emplace_back(_written, _now_ms);
+    }
+    if (_written == _transfer_bytes && !input.input_ended()) {
+        input.end_input();
+    }
+
+    _forward.advance(_now_ms * 1000);
+    _reverse.advance(_now_ms * 1000);
+    send_segments();
+
+    size_t readable = output.buffer_size();
+    output.pop_output((_read_bytes_per_ms > 0) ? min(readable, _read_bytes_per_ms) : readable);
+    while (!_write_times.empty() && _write_times.front().first <= output.bytes_read()) {
+        _latencies.push_back(_now_ms - _write_times.front().second);
+        _write_times.pop_front();
+    }
+    send_ack();
+
+    if (output.eof()) {
+        _report.completed = true;
+        _report.completion_ms = _now_ms;
+        return true;
+    }
+
+    _sender.tick(1);
+    _receiver.tick(1);
+    send_segments();
+    send_ack();
+    ++_now_ms;
+    return _now_ms > _time_limit_ms;
+}
+
+TransferReport LinkSimulator::report() {
+    _report.forward_drops = _forward.dropped();
+    _report.reverse_drops = _reverse.dropped();
+    if (_report.completed && _report.completion_ms > 0) {
+        _report.goodput_bps = _transfer_bytes * 8.0 * 1000 / _report.completion_ms;
+    }
+    if (!_latencies.empty()) {
+        sort(_latencies.begin(), _latencies.end());
+        const auto percentile = [this](const double p) {
+            return _latencies[static_cast<size_t>(p * (_latencies.size() - 1))];
+        };
+        _report.latency_p50_ms = percentile(0.5);
+        _report.latency_p90_ms = percentile(0.9);
+        _report.latency_p99_ms = percentile(0.99);
+        _report.latency_max_ms = _latencies.back();
+    }
+    return _report;
+}
@@ -0,0 +1,182 @@
+#ifndef SPONGE_LIBSPONGE_LINK_SIMULATOR_HH
+#define SPONGE_LIBSPONGE_LINK_SIMULATOR_HH
+
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * 单向链路的参数，各项概率均按包独立抽样，默认值为一条无损、无限带宽、无时延的链路
+ */
+struct LinkConfig {
+  // 链路带宽(bit/s)，为0表示不限速
+  uint64_t bandwidth_bps{0};
+
+  // 单向传播时延(ms)
+  uint64_t delay_ms{0};
+
+  // 随机丢包率
+  double loss_rate{0.0};
+
+  // 突发丢包(Gilbert-Elliott模型)：每个包从好状态进入坏状态、从坏状态回到好状态的概率，
+  // 以及坏状态下的丢包率
+  double burst_enter_rate{0.0};
+  double burst_exit_rate{1.0};
+  double burst_loss_rate{1.0};
+
+  // 乱序：以reorder_rate的概率使包额外延迟reorder_delay_ms毫秒
+  double reorder_rate{0.0};
+  uint64_t reorder_delay_ms{0};
+
+  // 重复：以duplicate_rate的概率把包投递两次
+  double duplicate_rate{0.0};
+
+  // 链路发送队列的长度(字节)，队列满时丢弃新到的包(drop-tail)，为0表示不限长
+  size_t queue_bytes{0};
+};
+
+/**
+ * 单向链路：包按带宽依次串行发送，经传播时延后到达对端。时间以微秒计，
+ * 由调用方推进，相同的随机数种子总会得到相同的丢包、乱序与重复序列。
+ */
+class Link {
+public:
+  using Deliver = std::function<void()>;
+
+private:
+  LinkConfig _config;
+  std::mt19937_64 &_rng;
+
+  // 链路发送完队列中已有的包的时刻(us)
+  uint64_t _busy_until_us{0};
+
+  // 仍在发送队列中的包的发送完成时刻与长度，用于计算队列占用
+  std::deque<std::pair<uint64_t, size_t>> _queue{};
+  size_t _queued_bytes{0};
+
+  // Gilbert-Elliott模型当前是否处于坏状态
+  bool _bursting{false};
+
+  // 在途的包：按(到达时刻, 发送顺序)排列
+  std::map<std::pair<uint64_t, uint64_t>, Deliver> _in_flight{};
+  uint64_t _next_packet{0};
+
+  uint64_t _dropped{0};
+
+  bool chance(const double probability);
+
+public:
+  Link(const LinkConfig &config, std::mt19937_64 &rng) : _config(config), _rng(rng) {}
+
+  // 在now_us时刻发送一个长为bytes字节的包，到达对端时调用deliver
+  void send(const uint64_t now_us, const size_t bytes, const Deliver &deliver);
+
+  // 依次投递到达时刻不晚于now_us的包
+  void advance(const uint64_t now_us);
+
+  // 被丢弃的包数(随机丢包、突发丢包与队列溢出)
+  uint64_t dropped() const { return _dropped; }
+};
+
+/**
+ * 一次传输的结果
+ */
+struct TransferReport {
+  bool completed{false};
+
+  // 从开始到接收方读完全部数据的虚拟时间(ms)
+  uint64_t completion_ms{0};
+
+  // 有效吞吐量(bit/s)：传输的数据量除以完成时间
+  double goodput_bps{0.0};
+
+  uint64_t segments_sent{0};
+  uint64_t retransmissions{0};
+  uint64_t acks_sent{0};
+  uint64_t forward_drops{0};
+  uint64_t reverse_drops{0};
+
+  // 每MSS字节的数据从写入发送方到被接收方读出的时延百分位数(ms)
+  uint64_t latency_p50_ms{0};
+  uint64_t latency_p90_ms{0};
+  uint64_t latency_p99_ms{0};
+  uint64_t latency_max_ms{0};
+};
+
+/**
+ * 进程内的网络模拟器：通过一对Link连接TCPSender与TCPReceiver，以1ms为步长推进
+ * 虚拟时间并调用双方的tick()，不依赖真实网络与墙上时间，结果可完全复现。
+ * 发送方与接收方的各项功能(拥塞控制、SACK、窗口缩放、延迟ACK等)由调用方事先配置。
+ */
+class LinkSimulator {
+private:
+  // 数据包与ACK包的首部开销(IP + TCP首部)
+  static constexpr size_t HEADER_BYTES = 40;
+
+  TCPSender &_sender;
+  TCPReceiver &_receiver;
+  std::mt19937_64 _rng;
+  Link _forward;
+  Link _reverse;
+
+  // ACK中是否携带SACK块
+  bool _sack{false};
+
+  // 应用每ms最多读出的字节数，为0表示每步读完全部数据
+  size_t _read_bytes_per_ms{0};
+
+  uint64_t _now_ms{0};
+  uint64_t _time_limit_ms{0};
+  TransferReport _report{};
+
+  // 应用写入发送方的数据：总量、已写入的量与每次写入的内容
+  size_t _transfer_bytes{0};
+  size_t _written{0};
+  std::string _chunk{};
+
+  // (写入后流中的累计字节数, 写入时刻)，数据被读出时得到其端到端时延
+  std::deque<std::pair<size_t, uint64_t>> _write_times{};
+  std::vector<uint64_t> _latencies{};
+
+  // 已发送过的最大绝对序号，用于区分新数据与重传
+  std::optional<WrappingInt32> _isn{};
+  uint64_t _highest_sent{0};
+
+  // 把发送方待发送的segment放上正向链路
+  void send_segments();
+
+  // 需要时把接收方的ACK放上反向链路
+  void send_ack();
+
+public:
+  LinkSimulator(TCPSender &sender,
+                TCPReceiver &receiver,
+                const LinkConfig &forward,
+                const LinkConfig &reverse,
+                const uint64_t seed = 1);
+
+  // 让接收方在ACK中携带SACK块
+  void enable_sack(const bool enable = true) { _sack = enable; }
+
+  // 模拟读得慢的应用：每ms最多从接收方读出bytes_per_ms字节，为0表示不限
+  void set_read_rate(const size_t bytes_per_ms) { _read_bytes_per_ms = bytes_per_ms; }
+
+  // 传输transfer_bytes字节的数据，直到接收方读完全部数据或虚拟时间超过time_limit_ms
+  TransferReport run(const size_t transfer_bytes, const uint64_t time_limit_ms = 600000);
+
+  // 逐步运行，供同时驱动多个连接的调用方使用：start之后反复调用step，
+  // 每次推进1ms虚拟时间，传输完成或超时后step返回true，再由report取得结果
+  void start(const size_t transfer_bytes, const uint64_t time_limit_ms = 600000);
+  bool step();
+  TransferReport report();
+};
+
+#endif  // SPONGE_LIBSPONGE_LINK_SIMULATOR_HH
@@ -0,0 +1,149 @@
+#ifndef SPONGE_LIBSPONGE_RING_DEQUE_HH
+#define SPONGE_LIBSPONGE_RING_DEQUE_HH
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * 只在队尾插入、从队首弹出的环形队列：容量取为2的幂，满时翻倍。
+ * 弹出的槽位被重置为T{}以释放元素持有的资源，槽位本身留给之后的元素复用，
+ * 队列长度达到稳定后插入与弹出都不再分配内存(std::deque每跨过一个内存块就要分配与释放一次)。
+ * 迭代器为随机访问迭代器，可用于lower_bound、find_if等算法，插入元素后失效。
+ */
+template <typename T>
+class RingDeque {
+private:
+  static constexpr size_t INITIAL_CAPACITY = 16;
+
+  std::vector<T> _slots{};
+  size_t _head{0};  // 队首元素所在的槽位
+  size_t _size{0};
+
+  size_t slot(const size_t index) const { return (_head + index) & (_slots.size() - 1); }
+
+  void grow() {
+    std::vector<T> slots(_slots.empty() ? INITIAL_CAPACITY : 2 * _slots.size());
+    for (size_t i = 0; i < _size; ++i) {
+      slots[i] = std::move(_slots[slot(i)]);
+    }
+    _slots = std::move(slots);
+    _head = 0;
+  }
+
+public:
+  template <bool Const>
+  class Iterator {
+  private:
+    using Ring = std::conditional_t<Const, const RingDeque, RingDeque>;
+    Ring *_ring{nullptr};
+    size_t _index{0};
+
+    friend class RingDeque;
+    friend class Iterator<!Const>;
+    Iterator(Ring *ring, const size_t index) : _ring(ring), _index(index) {}
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T *, T *>;
+    using reference = std::conditional_t<Const, const T &, T &>;
+
+    Iterator() = default;
+
+    // 普通迭代器可以隐式转换为const迭代器
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    Iterator(const Iterator<false> &other) : _ring(other._ring), _index(other._index) {}
+
+    reference operator*() const { return (*_ring)[_index]; }
+    pointer operator->() const { return &(*_ring)[_index]; }
+    reference operator[](const difference_type n) const { return (*_ring)[_index + n]; }
+
+    Iterator &operator++() {
+      ++_index;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++_index;
+      return old;
+    }
+    Iterator &operator--() {
+      --_index;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --_index;
+      return old;
+    }
+    Iterator &operator+=(const difference_type n) {
+      _index += n;
+      return *this;
+    }
+    Iterator &operator-=(const difference_type n) {
+      _index -= n;
+      return *this;
+    }
+    Iterator operator+(const difference_type n) const { return Iterator(_ring, _index + n); }
+    friend Iterator operator+(const difference_type n, const Iterator &it) { return it + n; }
+    Iterator operator-(const difference_type n) const { return Iterator(_ring, _index - n); }
+    difference_type operator-(const Iterator &other) const {
+      return static_cast<difference_type>(_index) - static_cast<difference_type>(other._index);
+    }
+
+    bool operator==(const Iterator &other) const { return _index == other._index; }
+    bool operator!=(const Iterator &other) const { return _index != other._index; }
+    bool operator<(const Iterator &other) const { return _index < other._index; }
+    bool operator>(const Iterator &other) const { return _index > other._index; }
+    bool operator<=(const Iterator &other) const { return _index <= other._index; }
+    bool operator>=(const Iterator &other) const { return _index >= other._index; }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  bool empty() const { return _size == 0; }
+  size_t size() const { return _size; }
+
+  // 当前容量：不超过它的元素数不会引起分配
+  size_t capacity() const { return _slots.size(); }
+
+  T &operator[](const size_t index) { return _slots[slot(index)]; }
+  const T &operator[](const size_t index) const { return _slots[slot(index)]; }
+
+  T &front() { return _slots[_head]; }
+  const T &front() const { return _slots[_head]; }
+  T &back() { return _slots[slot(_size - 1)]; }
+  const T &back() const { return _slots[slot(_size - 1)]; }
+
+  void push_back(T &&value) {
+    if (_size == _slots.size()) {
+      grow();
+    }
+    _slots[slot(_size)] = std::move(value);
+    ++_size;
+  }
+
+  void pop_front() {
+    _slots[_head] = T{};
+    _head = slot(1);
+    --_size;
+  }
+
+  void clear() {
+    while (!empty()) {
+      pop_front();
+    }
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, _size); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, _size); }
+};
+
+#endif  // SPONGE_LIBSPONGE_RING_DEQUE_HH
@@ -0,0 +1,201 @@
+#include "sharded_engine.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+//! \details 逐个字段混合后用splitmix64的终结函数打散，使相邻端口也能均匀地分布到各个shard
+size_t FourTupleHash::operator()(const FourTuple &tuple) const {
+    uint64_t h = (static_cast<uint64_t>(tuple.local_address) << 32) | tuple.remote_address;
+    h ^= (static_cast<uint64_t>(tuple.local_port) << 16 | tuple.remote_port) * 0x9e3779b97f4a7c15ull;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<size_t>(h ^ (h >> 31));
+}
+
+ShardedEngine::Connection::Connection(const EngineConfig &config, const ConnectionRequest &request)
+    : tuple(request.tuple)
+    , sender(config.sender_capacity, TCPConfig::TIMEOUT_DFLT, WrappingInt32{static_cast<uint32_t>(request.seed)})
+    , receiver(config.receiver_capacity)
+    , simulator(sender, receiver, request.forward, request.reverse, request.seed) {}
+
+ShardedEngine::Shard::Shard(const size_t index, const EngineConfig &config, const size_t ofo_memory_budget)
+    : _index(index), _config(config), _inbox(config.queue_capacity), _outbox(config.queue_capacity) {
+    if (ofo_memory_budget > 0) {
+        _memory_pool = make_shared<ReassemblyMemoryPool>(ofo_memory_budget);
+    }
+}
+
+ShardedEngine::Shard::~Shard() {
+    stop();
+    join();
+}
+
+void ShardedEngine::Shard::start() { _thread = thread(&Shard::run, this); }
+
+void ShardedEngine::Shard::join() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+//! \details 没有活跃连接时逐步退避，最终阻塞等待；收到停止请求且收件队列已空、所有连接都已完成后退出。
+//! 提交方先放入连接再请求停止，因此看到停止请求时收件队列中的连接一定可见。
+void ShardedEngine::Shard::run() {
+    ConnectionRequest request;
+    unsigned int idle_rounds = 0;
+    while (true) {
+        while (_inbox.pop(request)) {
+            open(request);
+            idle_rounds = 0;
+        }
+        if (!_active.empty()) {
+            step();
+        } else if (_stopping && _inbox.empty()) {
+            break;
+        } else {
+            back_off(idle_rounds);
+        }
+    }
+    _stopped = true;
+}
+
+//! \details 阻塞前先发布_sleeping再检查收件队列，提交方先放入连接再检查_sleeping，
+//! 两侧之间都有全序栅栏，因此至少一方能看到对方的写入，不会错过唤醒。
+void ShardedEngine::Shard::back_off(unsigned int &idle_rounds) {
+    ++idle_rounds;
+    if (idle_rounds <= IDLE_SPINS) {
+        return;
+    }
+    if (idle_rounds <= IDLE_SPINS + IDLE_YIELDS) {
+        this_thread::yield();
+        return;
+    }
+    unique_lock<mutex> lock(_idle_mutex);
+    _sleeping.store(true);
+    atomic_thread_fence(memory_order_seq_cst);
+    _idle_condition.wait(lock, [this] { return !_inbox.empty() || _stopping; });
+    _sleeping.store(false);
+    idle_rounds = 0;
+}
+
+void ShardedEngine::Shard::wake() {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_sleeping.load()) {
+        lock_guard<mutex> lock(_idle_mutex);
+        _idle_condition.notify_one();
+    }
+}
+
+bool ShardedEngine::Shard::submit(ConnectionRequest &&request) {
+    if (!_inbox.push(move(request))) {
+        return false;
+    }
+    wake();
+    return true;
+}
+
+void ShardedEngine::Shard::stop() {
+    _stopping = true;
+    wake();
+}
+
+void ShardedEngine::Shard::open(const ConnectionRequest &request) {
+    size_t slot = _slots.size();
+    if (!_free_slots.empty()) {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+    } else {
+        _slots.emplace_back();
+    }
+    Connection &connection = _slots[slot].emplace(_config, request);
+    connection.sender.attach_timer_wheel(_timer_wheel);
+    if (_memory_pool) {
+        connection.receiver.attach_memory_pool(_memory_pool);
+    }
+    if (_config.configure) {
+        _config.configure(connection.sender, connection.receiver, connection.simulator);
+    }
+    connection.simulator.start(request.transfer_bytes, _config.time_limit_ms);
+    _active.push_back(slot);
+}
+
+//! \details 结果队列满时等待提交方取走结果
+void ShardedEngine::Shard::step() {
+    for (size_t i = 0; i < _active.size();) {
+        const size_t slot = _active[i];
+        Connection &connection = _slots[slot].value();
+        if (!connection.simulator.step()) {
+            ++i;
+            continue;
+        }
+        ConnectionResult result{connection.tuple, _index, connection.simulator.report()};
+        while (!_outbox.push(move(result))) {
+            this_thread::yield();
+        }
+        _slots[slot].reset();
+        _free_slots.push_back(slot);
+        _active[i] = _active.back();
+        _active.pop_back();
+    }
+    _timer_wheel->advance(1);
+}
+
+ShardedEngine::ShardedEngine(const size_t shards, const EngineConfig &config) : _config(config) {
+    const size_t shard_count = max<size_t>(shards, 1);
+    size_t ofo_budget = 0;
+    if (_config.ofo_memory_budget > 0) {
+        ofo_budget = max<size_t>(_config.ofo_memory_budget / shard_count, 1);
+    }
+    for (size_t i = 0; i < shard_count; ++i) {
+        _shards.push_back(make_unique<Shard>(i, _config, ofo_budget));
+    }
+    for (auto &shard : _shards) {
+        shard->start();
+    }
+}
+
+ShardedEngine::~ShardedEngine() {
+    if (!_finished) {
+        finish();
+    }
+}
+
+size_t ShardedEngine::shard_of(const FourTuple &tuple) const { return FourTupleHash()(tuple) % _shards.size(); }
+
+void ShardedEngine::submit(ConnectionRequest request) {
+    Shard &shard = *_shards[shard_of(request.tuple)];
+    while (!shard.submit(move(request))) {
+        drain_results();
+        this_thread::yield();
+    }
+}
+
+void ShardedEngine::drain_results() {
+    ConnectionResult result;
+    for (auto &shard : _shards) {
+        while (shard->take_result(result)) {
+            _results.push_back(move(result));
+        }
+    }
+}
+
+vector<ConnectionResult> ShardedEngine::results() {
+    drain_results();
+    return exchange(_results, {});
+}
+
+vector<ConnectionResult> ShardedEngine::finish() {
+    _finished = true;
+    for (auto &shard : _shards) {
+        shard->stop();
+    }
+    while (!all_of(_shards.begin(), _shards.end(), [](const auto &shard) { return shard->stopped(); })) {
+        drain_results();
+        this_thread::yield();
+    }
+    for (auto &shard : _shards) {
+        shard->join();
+    }
+    return results();
+}
@@ -0,0 +1,187 @@
+#ifndef SPONGE_LIBSPONGE_SHARDED_ENGINE_HH
+#define SPONGE_LIBSPONGE_SHARDED_ENGINE_HH
+
+#include "link_simulator.hh"
+#include "spsc_queue.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "timer_wheel.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * 连接的四元组
+ */
+struct FourTuple {
+  uint32_t local_address{0};
+  uint32_t remote_address{0};
+  uint16_t local_port{0};
+  uint16_t remote_port{0};
+
+  bool operator==(const FourTuple &other) const {
+    return local_address == other.local_address && remote_address == other.remote_address &&
+           local_port == other.local_port && remote_port == other.remote_port;
+  }
+};
+
+struct FourTupleHash {
+  size_t operator()(const FourTuple &tuple) const;
+};
+
+/**
+ * 提交给引擎的一条连接：在模拟链路上从发送方向接收方传输transfer_bytes字节
+ */
+struct ConnectionRequest {
+  FourTuple tuple{};
+  size_t transfer_bytes{0};
+  LinkConfig forward{};
+  LinkConfig reverse{};
+  uint64_t seed{1};
+};
+
+/**
+ * 一条连接完成(或超时)后的结果
+ */
+struct ConnectionResult {
+  FourTuple tuple{};
+  size_t shard{0};
+  TransferReport report{};
+};
+
+struct EngineConfig {
+  size_t sender_capacity{TCPConfig::DEFAULT_CAPACITY};
+  size_t receiver_capacity{TCPConfig::DEFAULT_CAPACITY};
+
+  // 单条连接的虚拟时间上限(ms)
+  uint64_t time_limit_ms{600000};
+
+  // 每个shard收发队列的容量
+  size_t queue_capacity{1024};
+
+  // 所有连接的接收方合计最多缓存的乱序字节数，为0时不限制。shard之间不共享状态，
+  // 每个shard各用一个容量为其中1/shards的ReassemblyMemoryPool
+  size_t ofo_memory_budget{0};
+
+  // 在新建的连接开始传输前配置发送方与接收方(拥塞控制、SACK、窗口缩放等)
+  std::function<void(TCPSender &, TCPReceiver &, LinkSimulator &)> configure{};
+};
+
+/**
+ * 多核分片的连接引擎：按四元组的哈希把连接分配到各个shard，每个shard独占一个工作线程，
+ * 拥有自己的事件循环、时间轮与连接池，shard之间不共享任何可变状态。
+ * 提交连接与取回结果只通过每个shard各自的一对单生产者单消费者无锁队列进行：
+ * 提交方线程 -> shard的收件队列，shard -> 提交方线程的结果队列。
+ * submit/results/finish只能由同一个线程(提交方)调用。
+ */
+class ShardedEngine {
+private:
+  // 一条连接：发送方、接收方以及连接两者的模拟链路，构造后不再移动
+  struct Connection {
+    FourTuple tuple;
+    TCPSender sender;
+    TCPReceiver receiver;
+    LinkSimulator simulator;
+
+    Connection(const EngineConfig &config, const ConnectionRequest &request);
+  };
+
+  class Shard {
+  private:
+    size_t _index;
+    const EngineConfig &_config;
+
+    // 本shard所有发送方的重传计时器都由这个时间轮驱动，须在连接池之前构造、之后析构
+    std::shared_ptr<TimerWheel> _timer_wheel{std::make_shared<TimerWheel>()};
+
+    // 本shard所有接收方共享的乱序数据内存池，未设置预算时为空
+    std::shared_ptr<ReassemblyMemoryPool> _memory_pool{};
+
+    // 连接池：槽位只增不减，释放的槽位留给之后的连接复用，内存始终由本shard的线程分配与访问
+    std::deque<std::optional<Connection>> _slots{};
+    std::vector<size_t> _free_slots{};
+    std::vector<size_t> _active{};
+
+    SpscQueue<ConnectionRequest> _inbox;
+    SpscQueue<ConnectionResult> _outbox;
+
+    std::atomic<bool> _stopping{false};
+    std::atomic<bool> _stopped{false};
+    std::thread _thread{};
+
+    // 空闲时的退避：先轮询收件队列IDLE_SPINS次，再让出CPU IDLE_YIELDS次，
+    // 之后在条件变量上阻塞，直到提交方放入连接或请求停止时唤醒
+    static constexpr unsigned int IDLE_SPINS = 64;
+    static constexpr unsigned int IDLE_YIELDS = 64;
+    std::mutex _idle_mutex{};
+    std::condition_variable _idle_condition{};
+    std::atomic<bool> _sleeping{false};
+
+    // 事件循环
+    void run();
+
+    // 收件队列为空且没有活跃连接时调用，idle_rounds为连续空闲的轮数
+    void back_off(unsigned int &idle_rounds);
+
+    // 提交方调用：shard正阻塞等待时唤醒它
+    void wake();
+
+    // 在连接池中创建一条连接
+    void open(const ConnectionRequest &request);
+
+    // 所有活跃连接推进1ms，完成的连接把结果放入结果队列并归还槽位
+    void step();
+
+  public:
+    Shard(const size_t index, const EngineConfig &config, const size_t ofo_memory_budget);
+    Shard(const Shard &) = delete;
+    Shard &operator=(const Shard &) = delete;
+    ~Shard();
+
+    void start();
+
+    // 提交方线程调用
+    bool submit(ConnectionRequest &&request);
+    bool take_result(ConnectionResult &result) { return _outbox.pop(result); }
+    void stop();
+    bool stopped() const { return _stopped; }
+    void join();
+  };
+
+  EngineConfig _config;
+  std::vector<std::unique_ptr<Shard>> _shards{};
+  std::vector<ConnectionResult> _results{};
+  bool _finished{false};
+
+  // 取回各shard已完成的结果
+  void drain_results();
+
+public:
+  // 创建shards个shard并启动它们的工作线程
+  ShardedEngine(const size_t shards, const EngineConfig &config = {});
+  ShardedEngine(const ShardedEngine &) = delete;
+  ShardedEngine &operator=(const ShardedEngine &) = delete;
+  ~ShardedEngine();
+
+  // 四元组所属的shard
+  size_t shard_of(const FourTuple &tuple) const;
+
+  // 把连接交给其所属的shard，队列满时等待该shard取走
+  void submit(ConnectionRequest request);
+
+  // 取走目前已完成的连接的结果
+  std::vector<ConnectionResult> results();
+
+  // 不再提交新连接：等待所有连接完成并停止工作线程，返回其余的结果；析构时若尚未调用则自动调用
+  std::vector<ConnectionResult> finish();
+};
+
+#endif  // SPONGE_LIBSPONGE_SHARDED_ENGINE_HH
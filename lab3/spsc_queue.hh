@@ -0,0 +1,75 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+#define SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * 有界的单生产者单消费者无锁队列：容量取为2的幂，读写位置为单调递增的计数器。
+ * 生产者与消费者各自修改的计数器放在不同的缓存行中，并各自缓存一份对方的计数器，
+ * 只有在缓存值显示队列已满/已空时才重新读取，减少跨核的缓存行传递。
+ */
+template <typename T>
+class SpscQueue {
+private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  std::vector<T> _slots;
+  size_t _mask;
+
+  // 生产者：已写入的元素数，以及缓存的已读出元素数
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail{0};
+  size_t _cached_head{0};
+
+  // 消费者：已读出的元素数，以及缓存的已写入元素数
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head{0};
+  size_t _cached_tail{0};
+
+  static size_t round_up(const size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+public:
+  explicit SpscQueue(const size_t capacity) : _slots(round_up(capacity)), _mask(_slots.size() - 1) {}
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  // 生产者调用：队列已满时返回false，value保持不变
+  bool push(T &&value) {
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cached_head == _slots.size()) {
+      _cached_head = _head.load(std::memory_order_acquire);
+      if (tail - _cached_head == _slots.size()) {
+        return false;
+      }
+    }
+    _slots[tail & _mask] = std::move(value);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 消费者调用：队列为空时返回false
+  bool pop(T &value) {
+    const size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _cached_tail) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+      if (head == _cached_tail) {
+        return false;
+      }
+    }
+    value = std::move(_slots[head & _mask]);
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 任意一方调用，结果只是一个近似值
+  bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_QUEUE_HH
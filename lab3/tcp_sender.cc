@@ -2,6 +2,8 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 // Dummy implementation of a TCP sender
 
@@ -16,104 +18,653 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] chunked_stream whether the outgoing byte stream keeps written buffers as chunks (see ByteStream)
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const bool chunked_stream)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity) {}
+    , _stream(capacity, chunked_stream) {}
 
-uint64_t TCPSender::bytes_in_flight() const { 
-    uint64_t total_bytes = 0;
-    for (auto it : _outstanding_segments) {
-        total_bytes += it.second.length_in_sequence_space();
+//! \details 被判定丢失、等待重传的segment不在网络中，不计入_bytes_in_flight，但仍未被确认
+uint64_t TCPSender::bytes_in_flight() const { return _bytes_in_flight + _lost_bytes; }
+
+//! \param[in] controller the congestion control algorithm; the effective window becomes min(cwnd, rwnd)
+void TCPSender::set_congestion_controller(unique_ptr<CongestionController> controller) {
+    _congestion_controller = move(controller);
+}
+
+optional<uint64_t> TCPSender::cwnd() const {
+    return _congestion_controller ? optional<uint64_t>(_congestion_controller->cwnd()) : nullopt;
+}
+
+optional<uint64_t> TCPSender::ssthresh() const {
+    return _congestion_controller ? optional<uint64_t>(_congestion_controller->ssthresh()) : nullopt;
+}
+
+/**
+ * TCPSender::update_remaining_window : 计算接收方窗口中尚未被占用的部分；
+ * 若设置了拥塞控制算法，还要受到拥塞窗口中尚未被占用部分的限制。
+ */
+void TCPSender::update_remaining_window() {
+    // 视window_size = 0为1
+    uint64_t window_right_edge = _last_abs_ackno + ((_last_window_size == 0) ? 1 : _last_window_size);
+    _remaining_window_size = (window_right_edge > _next_seqno) ? window_right_edge - _next_seqno : 0;
+    if (_congestion_controller) {
+        uint64_t cwnd = _congestion_controller->cwnd() + _recovery_inflation;
+        uint64_t cwnd_available = (cwnd > _bytes_in_flight) ? cwnd - _bytes_in_flight : 0;
+        _remaining_window_size = min<uint64_t>(_remaining_window_size, cwnd_available);
     }
-    return total_bytes;
 }
 
 void TCPSender::fill_window() {
+    /* 被判定丢失的数据先于新数据发送 */
+    if (_lost_bytes > 0) {
+        retransmit_lost();
+    }
+    /* pacing：尚无发送速率时不限制；否则令牌为正时才能发送，GSO的segment也不超过令牌数(按MSS向上取整) */
+    optional<double> rate = _pacing ? pacing_rate() : nullopt;
+    if (rate.has_value()) {
+        refill_pacing_tokens();
+    }
     /* 只有在receiver的window size不为0，且FIN并未发送的情况下，才允许发送segment。 */
-    while ((_remaining_window_size > 0) && (!_fin_sent)) {
+    while ((_remaining_window_size > 0) && (!_fin_sent) && (!rate.has_value() || _pacing_tokens > 0)) {
         TCPSegment segment;
         segment.header().seqno = next_seqno();
         segment.header().syn = (next_seqno_absolute() == 0);
         size_t payload_size = min(_remaining_window_size-(segment.header().syn ? 1 : 0), 
-                                  TCPConfig::MAX_PAYLOAD_SIZE);
-        
-        /* 根据接收的window size判断是否包含EOF */
-        if (_remaining_window_size > _stream.buffer_size()) {
-            segment.header().fin = _stream.input_ended() ? true : false;
-            _fin_sent |= segment.header().fin;
+                                  TCPConfig::MAX_PAYLOAD_SIZE * _gso_segments);
+        if (rate.has_value()) {
+            size_t paced_segments = static_cast<size_t>(ceil(_pacing_tokens / TCPConfig::MAX_PAYLOAD_SIZE));
+            payload_size = min(payload_size, paced_segments * TCPConfig::MAX_PAYLOAD_SIZE);
+        }
+        segment.payload() = _stream.read_buffer(payload_size); // 设置此segment的数据
+
+        /* 数据读完后若输入已结束，且接收方窗口仍有空余，则捎带FIN */
+        if (_stream.eof() && (_remaining_window_size > segment.length_in_sequence_space())) {
+            segment.header().fin = true;
+            _fin_sent = true;
         }
-        segment.payload() = _stream.read(payload_size); // 设置此segment的数据
 
         /* 不包含任何SYN、FIN和数据位的segment应当忽略 */
         if (segment.length_in_sequence_space() == 0) {
             break;
         }
 
-        _outstanding_segments.emplace(next_seqno_absolute(), segment);
-        _segments_out.emplace(segment);
+        size_t length = segment.length_in_sequence_space();
+        _outstanding_segments.push_back({next_seqno_absolute(), move(segment), now_ms(), false, false, false});
+        _bytes_in_flight += length;
+        send_segment(_outstanding_segments.back().segment);
         _retransmission_timer.start(_initial_retransmission_timeout);
-        _next_seqno += segment.length_in_sequence_space();
-        _remaining_window_size -= segment.length_in_sequence_space();
+        _next_seqno += length;
+        _remaining_window_size -= length;
+        if (rate.has_value()) {
+            _pacing_tokens -= length;
+        }
+    }
+    /* 重传计时器刚刚启动，在时间轮上设置超时 */
+    if (_timer_wheel && !_rto_timer_id.has_value() && _retransmission_timer.rto().has_value()) {
+        rearm_timer_wheel();
+    }
+    bool has_data = (_stream.buffer_size() > 0) || _stream.eof();
+    _pacing_limited = rate.has_value() && (_pacing_tokens <= 0) && (_remaining_window_size > 0) && !_fin_sent &&
+                      has_data;
+    if (_pacing_limited) {
+        arm_pacing_timer();
+    }
+}
+
+//! \param[in] rate_bps the pacing rate in bits per second, or 0 to derive it from the window and SRTT
+//! \param[in] burst_bytes the depth of the token bucket
+void TCPSender::enable_pacing(const uint64_t rate_bps, const size_t burst_bytes) {
+    _pacing = true;
+    _pacing_fixed_rate = rate_bps / 8000.0;
+    _pacing_burst = max<size_t>(burst_bytes, 1);
+    _pacing_tokens = _pacing_burst;
+    _pacing_refilled_ms = now_ms();
+}
+
+/**
+ * TCPSender::pacing_rate : 每个RTT发出一个窗口的速率再乘以增益(同Linux)：慢启动前期窗口每个RTT翻倍，
+ * 增益为2才能跟上；此后为1.2，留出余量以免pacing本身成为瓶颈。丢包后拥塞窗口骤减，
+ * 窗口取拥塞窗口与在途字节数中的较大者，使恢复期间的发送速率平滑下降。
+ */
+optional<double> TCPSender::pacing_rate() const {
+    if (!_pacing) {
+        return nullopt;
+    }
+    if (_pacing_fixed_rate > 0) {
+        return _pacing_fixed_rate;
+    }
+    if (_congestion_controller && _congestion_controller->pacing_rate().has_value()) {
+        return _congestion_controller->pacing_rate();
+    }
+    optional<double> srtt = _retransmission_timer.srtt();
+    if (!srtt.has_value()) {
+        return nullopt;
+    }
+    double window = static_cast<double>(_last_window_size);
+    double gain = 1.2;
+    if (_congestion_controller) {
+        uint64_t cwnd = _congestion_controller->cwnd();
+        window = static_cast<double>(max(cwnd, _bytes_in_flight));
+        gain = (cwnd < _congestion_controller->ssthresh() / 2) ? 2.0 : 1.2;
+    }
+    double rate = gain * window / max(srtt.value(), 1.0);
+    return (rate > 0) ? optional<double>(rate) : nullopt;
+}
+
+/**
+ * TCPSender::refill_pacing_tokens : 按上次补充以来流逝的时间补充令牌，不限制计入的时间。
+ * 这段时间一直受pacing限制时，补充的令牌先偿还欠额，余下的全部保留(不超过这次补充的量)，
+ * 两次补充相隔多久都不会损失发送速率；否则令牌最多积累到_pacing_burst，避免空闲后突发。
+ */
+void TCPSender::refill_pacing_tokens() {
+    uint64_t now = now_ms();
+    uint64_t elapsed = now - _pacing_refilled_ms;
+    _pacing_refilled_ms = now;
+    optional<double> rate = pacing_rate();
+    if (!rate.has_value() || (elapsed == 0)) {
+        return;
     }
+    double refill = rate.value() * elapsed;
+    double limit = _pacing_limited ? max(static_cast<double>(_pacing_burst), refill) : _pacing_burst;
+    _pacing_tokens = min(_pacing_tokens + refill, limit);
+}
+
+/**
+ * TCPSender::arm_pacing_timer : 按欠额与发送速率计算令牌重新变为正数的时刻(至少1ms后)，
+ * 届时再调用fill_window；已设置的计时器不重复设置。
+ */
+void TCPSender::arm_pacing_timer() {
+    if (!_timer_wheel || _pacing_timer_id.has_value()) {
+        return;
+    }
+    optional<double> rate = pacing_rate();
+    if (!rate.has_value()) {
+        return;
+    }
+    uint64_t delay_ms = max<uint64_t>(static_cast<uint64_t>(floor(-_pacing_tokens / rate.value())) + 1, 1);
+    _pacing_timer_id = _timer_wheel->arm(delay_ms, [this]() {
+        _pacing_timer_id = nullopt;
+        fill_window();
+    });
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) { 
+//! \param window_size The remote receiver's advertised window size (before applying the window scale)
+//! \param sack_blocks The ranges above the ackno that the remote receiver already holds
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint16_t window_size,
+                             const vector<SackBlock> &sack_blocks) {
     uint64_t abs_ackno = unwrap(ackno, _isn, _last_abs_ackno);
-    /* 检验此次ackno的合理性 */
-    if ((abs_ackno < _last_abs_ackno) || 
-        (abs_ackno > _last_abs_ackno+bytes_in_flight()) ||
-        ((_last_abs_ackno != 0) && (abs_ackno == _last_abs_ackno) && (window_size == _last_window_size)) ) {
+    uint64_t window = static_cast<uint64_t>(window_size) << _peer_window_shift;
+    /* 检验此次ackno的合理性：不能确认尚未发送的数据，也不能比上一次的ackno更旧 */
+    if ((abs_ackno > _next_seqno) || (abs_ackno < _last_abs_ackno)) {
         return;
     }
 
-    /* 清除已确认的 outstanding segment */
-    auto it = _outstanding_segments.begin();
-    while (it != _outstanding_segments.end()) {
-        uint64_t abs_endno = it->first + it->second.length_in_sequence_space();
-        if (abs_endno > abs_ackno) {
+    /* 重复ACK：没有确认新数据、窗口不变且仍有未确认的数据 */
+    bool duplicate = (abs_ackno == _last_abs_ackno) && (window == _last_window_size) &&
+                     !_outstanding_segments.empty();
+
+    /* 清除已确认的 outstanding segment，队列按序号有序，只需从队首弹出 */
+    optional<uint64_t> rtt_sample{};
+    while (!_outstanding_segments.empty()) {
+        const OutstandingSegment &front = _outstanding_segments.front();
+        if (front.abs_seqno + front.segment.length_in_sequence_space() > abs_ackno) {
             break;
         }
-        it = _outstanding_segments.erase(it);
+        /* Karn算法：重传过的segment无法区分是哪一次发送被确认，不作为RTT样本；
+           被SACK的segment早已到达，到此次ACK为止还包含了修复空洞的时间，同样不作为样本 */
+        if (!front.sacked) {
+            rtt_sample = front.retransmitted ? nullopt : optional<uint64_t>(now_ms() - front.sent_time_ms);
+        }
+        if (front.sacked) {
+            _sacked_bytes -= front.segment.length_in_sequence_space();
+        } else if (front.lost) {
+            _lost_bytes -= front.segment.length_in_sequence_space();
+        } else {
+            _bytes_in_flight -= front.segment.length_in_sequence_space();
+        }
+        _outstanding_segments.pop_front();
     }
 
-    /* 如果此次ACK报文指定的有效滑动窗口小于上一次的有效滑动窗口，则无需传送新的segment，直接退出函数。 */
-    if ((_last_abs_ackno != 0) && 
-        ((abs_ackno+window_size) == (_last_abs_ackno+_last_window_size))) {
-        return;
+    /* GSO模式下队首的大segment被部分确认：去掉已确认的前缀，只保留未确认的部分 */
+    if ((_gso_segments > 1) && !_outstanding_segments.empty() &&
+        (_outstanding_segments.front().abs_seqno < abs_ackno)) {
+        OutstandingSegment &front = _outstanding_segments.front();
+        uint64_t acked_length = abs_ackno - front.abs_seqno;
+        TCPHeader &header = front.segment.header();
+        size_t payload_acked = acked_length - (header.syn ? 1 : 0);
+        header.syn = false;
+        header.seqno = wrap(abs_ackno, _isn);
+        front.segment.payload().remove_prefix(payload_acked);
+        front.abs_seqno = abs_ackno;
+        if (!front.sacked) {
+            rtt_sample = front.retransmitted ? nullopt : optional<uint64_t>(now_ms() - front.sent_time_ms);
+        }
+        if (front.sacked) {
+            _sacked_bytes -= acked_length;
+        } else if (front.lost) {
+            _lost_bytes -= acked_length;
+        } else {
+            _bytes_in_flight -= acked_length;
+        }
     }
-    _last_abs_ackno = abs_ackno;
 
-    /* retransmission timer 设置 */
-    _retransmission_timer.reset(_initial_retransmission_timeout);
+    /* 确认了新数据时才重置 retransmission timer，并通知拥塞控制算法；
+       丢包恢复中没有越过恢复点的部分确认不增长拥塞窗口(RFC 6582) */
+    bool new_data_acked = abs_ackno > _last_abs_ackno;
+    bool partial_ack = _recovery_point.has_value() && (abs_ackno < _recovery_point.value());
+    if (new_data_acked) {
+        if (_congestion_controller && !partial_ack) {
+            _congestion_controller->on_ack({now_ms(), abs_ackno - _last_abs_ackno, _bytes_in_flight, rtt_sample});
+        }
+        if (rtt_sample.has_value()) {
+            _retransmission_timer.add_rtt_sample(rtt_sample.value());
+        }
+        uint64_t acked_bytes = abs_ackno - _last_abs_ackno;
+        _last_abs_ackno = abs_ackno;
+        _retransmission_timer.reset(_initial_retransmission_timeout);
+        _dup_acks = 0;
+        if (_recovery_point.has_value() && (abs_ackno >= _recovery_point.value())) {
+            _recovery_point = nullopt; // 丢失前发送的数据已全部被确认，退出丢包恢复
+            _recovery_inflation = 0;
+        } else if (_recovery_point.has_value() && _fast_retransmit) {
+            /* NewReno部分确认：下一个空洞也已丢失，立即重传；窗口膨胀量扣除新确认的数据后再加一个MSS */
+            if (retransmit_first_hole() && _stats) {
+                _stats->fast_retransmission();
+            }
+            _recovery_inflation = (_recovery_inflation > acked_bytes) ? _recovery_inflation - acked_bytes : 0;
+            _recovery_inflation += TCPConfig::MAX_PAYLOAD_SIZE;
+        }
+    } else if (duplicate && _fast_retransmit) {
+        duplicate_ack_received();
+    }
+    if (duplicate && _stats) {
+        _stats->duplicate_ack();
+    }
     if (_outstanding_segments.empty()) {
         _retransmission_timer.stop();
     }
-    
-    /* 设置新的 _last_window_size, 并填充 receiver 的滑动窗口*/
-    _last_window_size = window_size;
-    _remaining_window_size = (window_size == 0) ? 1 : window_size; // 视window_size = 0为1
+    if (new_data_acked || _outstanding_segments.empty()) {
+        rearm_timer_wheel();
+    }
+
+    /* SACK reneging(RFC 2018)：累积确认没有越过一个已被SACK的segment，说明接收方丢弃了它的全部或一部分。
+       此前的SACK标记都不再可信，全部改为丢失，再按本次ACK的SACK块重新标记仍在接收方的数据 */
+    if (!_outstanding_segments.empty() && _outstanding_segments.front().sacked) {
+        for (OutstandingSegment &outstanding : _outstanding_segments) {
+            if (outstanding.sacked) {
+                outstanding.sacked = false;
+                outstanding.lost = true;
+            }
+        }
+        _lost_bytes += _sacked_bytes;
+        _sacked_bytes = 0;
+    }
+
+    if (!sack_blocks.empty()) {
+        sack_received(sack_blocks);
+    }
+
+    /* 设置新的 _last_window_size, 并填充 receiver 的滑动窗口中尚未被占用的部分 */
+    if ((window == 0) && (_last_window_size != 0) && _stats) {
+        _stats->zero_window();
+    }
+    _last_window_size = window;
+    update_remaining_window();
     fill_window(); // 填充最新的window_size
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
+//! \note when a TimerWheel is attached, the wheel fires retransmission timeouts and this only advances the clock
 void TCPSender::tick(const size_t ms_since_last_tick) { 
-    /**
-     * 如果重传计时器返回超时，则将序列号最小的segment重传。
-     * 此时若receiver返回的window size不为0，则说明可能
-     * 存在网络拥堵问题，采用二进制避退算法，即将重传计时器
-     * RTO加倍。
-     */
-    if (_retransmission_timer.expired(ms_since_last_tick)) {
-        if (!_outstanding_segments.empty()) {
-            _segments_out.emplace(_outstanding_segments.begin()->second);
+    _time_elapsed += ms_since_last_tick;
+    /* 以tick时的状态近似整段时间：有数据待发但窗口已满为受窗口限制，窗口有空余但无数据可发为受应用限制 */
+    if (_stats && (_next_seqno > 0) && !_fin_sent) {
+        bool has_data = (_stream.buffer_size() > 0) || _stream.eof();
+        if (has_data && (_remaining_window_size == 0)) {
+            _stats->window_limited(ms_since_last_tick);
+        } else if (!has_data && (_remaining_window_size > 0)) {
+            _stats->app_limited(ms_since_last_tick);
+        } else if (has_data && _pacing && (_pacing_tokens <= 0)) {
+            _stats->pacing_limited(ms_since_last_tick);
+        }
+    }
+    if (!_timer_wheel && _retransmission_timer.expired(ms_since_last_tick)) {
+        retransmission_timeout();
+    }
+    /* 上次只因令牌耗尽而停止发送时，补充令牌后发出被pacing推迟的segment(SYN仍由调用方通过fill_window发出) */
+    if (_pacing && _pacing_limited && (_next_seqno > 0)) {
+        fill_window();
+    }
+}
+
+/**
+ * TCPSender::retransmission_timeout : 重传计时器超时的处理。
+ * 将序列号最小的空洞(全部被SACK时为队首)重传，此时若receiver返回的window size不为0，
+ * 则说明可能存在网络拥堵问题，采用二进制避退算法，即将重传计时器RTO加倍。
+ */
+void TCPSender::retransmission_timeout() {
+    bool retransmitted = retransmit_first_hole();
+    /* 所有outstanding segment都已被SACK时没有空洞可重传：接收方可能已丢弃这些数据(RFC 2018第8节)，
+       清除队首的SACK标记并重传它 */
+    if (!retransmitted && !_outstanding_segments.empty()) {
+        OutstandingSegment &front = _outstanding_segments.front();
+        front.sacked = false;
+        _sacked_bytes -= front.segment.length_in_sequence_space();
+        _bytes_in_flight += front.segment.length_in_sequence_space();
+        front.retransmitted = true;
+        send_segment(front.segment);
+        retransmitted = true;
+    }
+    if (retransmitted && _stats) {
+        _stats->rto_retransmission();
+    }
+    /* 超时意味着快速恢复失败，退出丢包恢复 */
+    _recovery_point = nullopt;
+    _recovery_inflation = 0;
+    _dup_acks = 0;
+    if (_last_window_size > 0) {
+        _retransmission_timer.double_rto();
+        if (_congestion_controller) {
+            _congestion_controller->on_timeout(now_ms(), _bytes_in_flight);
+            mark_lost_after_timeout();
+        }
+    }
+    rearm_timer_wheel();
+}
+
+/**
+ * TCPSender::mark_lost_after_timeout : 超时后除刚重传的segment外，未被SACK的segment都视为丢失(RFC 5681的
+ * go-back-N，RFC 6675第5.1节)，之后随拥塞窗口在慢启动中增长依次重传，不必每个空洞都等一次超时。
+ * 只在安装了拥塞控制时调用：超时后的拥塞窗口限制了retransmit_lost一次重传的量。
+ */
+void TCPSender::mark_lost_after_timeout() {
+    bool first_hole = true;
+    for (OutstandingSegment &outstanding : _outstanding_segments) {
+        if (outstanding.sacked || outstanding.lost) {
+            continue;
+        }
+        if (first_hole) {
+            first_hole = false;
+            continue;
+        }
+        outstanding.lost = true;
+        _bytes_in_flight -= outstanding.segment.length_in_sequence_space();
+        _lost_bytes += outstanding.segment.length_in_sequence_space();
+    }
+    update_remaining_window();
+}
+
+/**
+ * TCPSender::attach_timer_wheel : 改由共享的时间轮驱动重传计时器，
+ * 此后时间轮的当前时间即为发送方的时钟。
+ * @param wheel : 共享的时间轮
+ */
+void TCPSender::attach_timer_wheel(shared_ptr<TimerWheel> wheel) {
+    if (_timer_wheel && _rto_timer_id.has_value()) {
+        _timer_wheel->cancel(_rto_timer_id.value());
+    }
+    if (_timer_wheel && _pacing_timer_id.has_value()) {
+        _timer_wheel->cancel(_pacing_timer_id.value());
+    }
+    _rto_timer_id = nullopt;
+    _pacing_timer_id = nullopt;
+    _timer_wheel = move(wheel);
+    _pacing_refilled_ms = now_ms();
+    rearm_timer_wheel();
+}
+
+/**
+ * TCPSender::rearm_timer_wheel : 重传计时器启动、重置、加倍或关闭后，
+ * 在时间轮上取消旧的超时，并按当前的RTO重新设置。
+ */
+void TCPSender::rearm_timer_wheel() {
+    if (!_timer_wheel) {
+        return;
+    }
+    if (_rto_timer_id.has_value()) {
+        _timer_wheel->cancel(_rto_timer_id.value());
+        _rto_timer_id = nullopt;
+    }
+    if (_retransmission_timer.rto().has_value()) {
+        _rto_timer_id = _timer_wheel->arm(_retransmission_timer.rto().value(), [this]() {
+            _rto_timer_id = nullopt;
+            retransmission_timeout();
+        });
+    }
+}
+
+uint64_t TCPSender::now_ms() const { return _timer_wheel ? _timer_wheel->now() : _time_elapsed; }
+
+TCPSender::~TCPSender() {
+    if (_timer_wheel && _rto_timer_id.has_value()) {
+        _timer_wheel->cancel(_rto_timer_id.value());
+    }
+    if (_timer_wheel && _pacing_timer_id.has_value()) {
+        _timer_wheel->cancel(_pacing_timer_id.value());
+    }
+}
+
+//! \param[in] shift the peer's window scale shift, capped at 14 as RFC 7323 requires
+void TCPSender::set_peer_window_shift(const uint8_t shift) { _peer_window_shift = min<uint8_t>(shift, 14); }
+
+void TCPSender::enable_fast_retransmit(const bool enable) { _fast_retransmit = enable; }
+
+void TCPSender::enable_adaptive_rto(const unsigned int min_rto, const unsigned int max_rto) {
+    _retransmission_timer.enable_adaptive_rto(min_rto, max_rto);
+}
+
+/**
+ * TCPSender::retransmit_first_hole : 被SACK确认的segment无需重传，重传第一个未被SACK的segment。
+ */
+bool TCPSender::retransmit_first_hole() {
+    auto hole = find_if(_outstanding_segments.begin(), _outstanding_segments.end(),
+                        [](const OutstandingSegment &outstanding) { return !outstanding.sacked; });
+    if (hole == _outstanding_segments.end()) {
+        return false;
+    }
+    if (hole->lost) {
+        hole->lost = false;
+        _lost_bytes -= hole->segment.length_in_sequence_space();
+        _bytes_in_flight += hole->segment.length_in_sequence_space();
+    }
+    hole->retransmitted = true;
+    send_segment(hole->segment);
+    return true;
+}
+
+/**
+ * TCPSender::retransmit_lost : 按序号从小到大重传被判定丢失的segment，重传后重新计入在途字节数，
+ * 在途字节数达到拥塞窗口时停止，其余的等之后的ACK腾出窗口再重传。
+ * 没有拥塞控制时没有窗口约束重传，每次只重传最早的一个，以免一次重发整个窗口。
+ */
+void TCPSender::retransmit_lost() {
+    for (OutstandingSegment &outstanding : _outstanding_segments) {
+        if (_lost_bytes == 0) {
+            break;
+        }
+        if (_congestion_controller &&
+            (_bytes_in_flight >= _congestion_controller->cwnd() + _recovery_inflation)) {
+            break;
+        }
+        if (!outstanding.lost) {
+            continue;
+        }
+        size_t length = outstanding.segment.length_in_sequence_space();
+        outstanding.lost = false;
+        outstanding.retransmitted = true;
+        _lost_bytes -= length;
+        _bytes_in_flight += length;
+        send_segment(outstanding.segment);
+        if (_stats) {
+            _stats->lost_retransmission();
+        }
+        if (!_congestion_controller) {
+            break;
+        }
+    }
+    update_remaining_window();
+}
+
+/**
+ * TCPSender::duplicate_ack_received : 第DUP_THRESH个重复ACK触发快速重传并进入快速恢复，
+ * 此时拥塞窗口膨胀DUP_THRESH个MSS(这些segment已离开网络)；快速恢复期间每个额外的重复ACK
+ * 再使窗口膨胀一个MSS，使得空洞修复期间仍能发送新数据。
+ */
+void TCPSender::duplicate_ack_received() {
+    ++_dup_acks;
+    if (_dup_acks == DUP_THRESH && !_recovery_point.has_value()) {
+        if (retransmit_first_hole() && _stats) {
+            _stats->fast_retransmission();
+        }
+        _recovery_point = _next_seqno;
+        if (_congestion_controller) {
+            _congestion_controller->on_loss(now_ms(), _bytes_in_flight);
+        }
+        _recovery_inflation = DUP_THRESH * TCPConfig::MAX_PAYLOAD_SIZE;
+    } else if (_dup_acks > DUP_THRESH && _recovery_point.has_value()) {
+        _recovery_inflation += TCPConfig::MAX_PAYLOAD_SIZE;
+    }
+}
+
+/**
+ * TCPSender::sack_received : 将被SACK块完整覆盖的outstanding segment标记为已SACK，不再计入在途字节数；
+ * 随后按RFC 6675的判定，其后已有超过(DUP_THRESH-1)*MSS个字节被SACK的空洞视为丢失：进入恢复时的第一个
+ * 立即重传(RFC 6675第5节)，其余的标记为丢失，由ack_received最后的fill_window经retransmit_lost在拥塞窗口内
+ * 重传，从而在一轮恢复中修复窗口内的多个丢包。
+ */
+void TCPSender::sack_received(const vector<SackBlock> &sack_blocks) {
+    bool newly_sacked = false;
+    for (const SackBlock &block : sack_blocks) {
+        uint64_t left = unwrap(block.left, _isn, _last_abs_ackno);
+        uint64_t right = unwrap(block.right, _isn, _last_abs_ackno);
+        if ((left >= right) || (right > _next_seqno)) {
+            continue;
         }
-        if (_last_window_size > 0) {
-            _retransmission_timer.double_rto();
+        auto it = lower_bound(_outstanding_segments.begin(), _outstanding_segments.end(), left,
+                              [](const OutstandingSegment &outstanding, const uint64_t seqno) {
+                                  return outstanding.abs_seqno < seqno;
+                              });
+        for (; it != _outstanding_segments.end(); ++it) {
+            size_t length = it->segment.length_in_sequence_space();
+            if (it->abs_seqno + length > right) {
+                break;
+            }
+            if (it->lost) {
+                it->lost = false;
+                it->sacked = true;
+                _lost_bytes -= length;
+                _sacked_bytes += length;
+            } else if (!it->sacked) {
+                it->sacked = true;
+                _bytes_in_flight -= length;
+                _sacked_bytes += length;
+                newly_sacked = true;
+            }
         }
     }
+    if (!newly_sacked) {
+        return;
+    }
+
+    /* 从队首开始，sacked_above为当前segment之后被SACK的字节数 */
+    bool loss_detected = false;
+    bool entering_recovery = !_recovery_point.has_value();
+    uint64_t flight_before_loss = _bytes_in_flight;
+    uint64_t sacked_above = _sacked_bytes;
+    for (OutstandingSegment &outstanding : _outstanding_segments) {
+        if (sacked_above <= (DUP_THRESH - 1) * TCPConfig::MAX_PAYLOAD_SIZE) {
+            break;
+        }
+        if (outstanding.sacked) {
+            sacked_above -= outstanding.segment.length_in_sequence_space();
+        } else if (!outstanding.retransmitted && !outstanding.lost) {
+            if (entering_recovery && !loss_detected) {
+                outstanding.retransmitted = true;
+                send_segment(outstanding.segment);
+                if (_stats) {
+                    _stats->fast_retransmission();
+                }
+            } else {
+                outstanding.lost = true;
+                _bytes_in_flight -= outstanding.segment.length_in_sequence_space();
+                _lost_bytes += outstanding.segment.length_in_sequence_space();
+            }
+            loss_detected = true;
+        }
+    }
+
+    /* 每个丢包恢复周期只通知一次拥塞控制算法 */
+    if (loss_detected && entering_recovery) {
+        _recovery_point = _next_seqno;
+        if (_congestion_controller) {
+            _congestion_controller->on_loss(now_ms(), flight_before_loss);
+        }
+    }
+}
+
+//! \param[in] batch segments are appended to it, in the order they were enqueued
+//! \param[in] max_segments the most segments to move out in one call
+//! \returns the number of segments moved into `batch`
+size_t TCPSender::segments_out_batch(vector<TCPSegment> &batch, const size_t max_segments) {
+    size_t count = min(max_segments, _segments_out.size());
+    batch.reserve(batch.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        batch.push_back(move(_segments_out.front()));
+        _segments_out.pop();
+    }
+    return count;
+}
+
+//! \param[in] max_segments how many MSS-sized pieces one segment may carry; 1 disables GSO
+void TCPSender::enable_gso(const size_t max_segments) { _gso_segments = max<size_t>(max_segments, 1); }
+
+/**
+ * SegmentPiece::segment : 转换成TCPSegment。最后一段(区间延伸到负载末尾)只需去掉共享存储的前缀，
+ * 其余的段复制自己的负载。
+ * @return : 与本段头部、负载相同的TCPSegment
+ */
+TCPSegment SegmentPiece::segment() const {
+    TCPSegment segment;
+    segment.header() = _header;
+    if (_offset + _length == _storage.size()) {
+        segment.payload() = _storage;
+        segment.payload().remove_prefix(_offset);
+    } else {
+        segment.payload() = Buffer(string(payload()));
+    }
+    return segment;
+}
+
+/**
+ * TCPSender::split_segment : 把GSO产生的大segment按MSS切分成可以发送的段，
+ * SYN留在第一段上，FIN留在最后一段上，序号依次递增。各段与原segment共享负载存储，不复制负载。
+ * @param  segment : 待切分的segment
+ * @param  mss     : 每段的最大负载
+ * @return         : 切分后的段，负载不超过mss时只有一段，覆盖整个负载
+ */
+vector<SegmentPiece> TCPSender::split_segment(const TCPSegment &segment, const size_t mss) {
+    const size_t payload_size = segment.payload().size();
+    if (payload_size <= mss) {
+        return {SegmentPiece(segment.header(), segment.payload(), 0, payload_size)};
+    }
+    vector<SegmentPiece> pieces;
+    pieces.reserve((payload_size + mss - 1) / mss);
+    WrappingInt32 seqno = segment.header().seqno;
+    for (size_t offset = 0; offset < payload_size; offset += mss) {
+        SegmentPiece piece(segment.header(), segment.payload(), offset, min(mss, payload_size - offset));
+        piece.header().seqno = seqno;
+        piece.header().syn = segment.header().syn && (offset == 0);
+        piece.header().fin = segment.header().fin && (offset + mss >= payload_size);
+        seqno = seqno + piece.length_in_sequence_space();
+        pieces.push_back(move(piece));
+    }
+    return pieces;
 }
 
 unsigned int TCPSender::consecutive_retransmissions() const { 
@@ -123,7 +674,14 @@ unsigned int TCPSender::consecutive_retransmissions() const {
 void TCPSender::send_empty_segment() {
     TCPSegment empty_segment;
     empty_segment.header().seqno = next_seqno();
-    _segments_out.emplace(empty_segment);
+    send_segment(empty_segment);
+}
+
+void TCPSender::send_segment(const TCPSegment &segment) {
+    _segments_out.emplace(segment);
+    if (_stats) {
+        _stats->segment_sent(segment.payload().size());
+    }
 }
 
 
@@ -137,7 +695,7 @@ void RetransmissionTimer::start(const uint16_t initial_rto) {
     /* 初次启动 */
     if (!_rto.has_value()) { 
         _ms_passed = 0;
-        _rto = initial_rto;
+        _rto = base_rto(initial_rto);
         _consecutive_retx = 0;
     }
 }
@@ -155,20 +713,23 @@ void RetransmissionTimer::stop() {
 
 /**
  * RetransmissionTimer::reset : 重置重传计时器。
- * @param reset_rto : 重置的指定的RTO
+ * @param reset_rto : 重置的指定的RTO，自适应模式下已有RTT样本时改用估计的RTO
  */
 void RetransmissionTimer::reset(const uint16_t reset_rto) {
     _ms_passed = 0;
-    _rto = reset_rto;
+    _rto = base_rto(reset_rto);
     _consecutive_retx = 0;
 }
 
 /**
- * RetransmissionTimer::double_rto : 将当前重传计时器的RTO翻倍
+ * RetransmissionTimer::double_rto : 将当前重传计时器的RTO翻倍，自适应模式下不超过RTO上界
  */
 void RetransmissionTimer::double_rto() {
     _ms_passed = 0;
     _rto = _rto.value() << 1; 
+    if (_adaptive) {
+        _rto = min(_rto.value(), _max_rto);
+    }
     ++_consecutive_retx; 
 }
 
@@ -187,4 +748,46 @@ bool RetransmissionTimer::expired(const size_t ms_since_last_check) {
     return ret; 
 }
 
-////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+/**
+ * RetransmissionTimer::enable_adaptive_rto : 启用自适应RTO。
+ * @param min_rto : RTO下界
+ * @param max_rto : RTO上界
+ */
+void RetransmissionTimer::enable_adaptive_rto(const unsigned int min_rto, const unsigned int max_rto) {
+    _adaptive = true;
+    _min_rto = min_rto;
+    _max_rto = max(min_rto, max_rto);
+}
+
+/**
+ * RetransmissionTimer::add_rtt_sample : 按RFC 6298更新SRTT与RTTVAR，
+ * 第一个样本R使 SRTT = R, RTTVAR = R/2；之后 RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|，
+ * SRTT = 7/8 SRTT + 1/8 R。
+ * @param rtt_ms : 未经重传的segment的RTT样本(Karn算法由调用方保证)
+ */
+void RetransmissionTimer::add_rtt_sample(const uint64_t rtt_ms) {
+    double r = static_cast<double>(rtt_ms);
+    if (!_srtt.has_value()) {
+        _srtt = r;
+        _rttvar = r / 2;
+    } else {
+        _rttvar = 0.75 * _rttvar + 0.25 * abs(_srtt.value() - r);
+        _srtt = 0.875 * _srtt.value() + 0.125 * r;
+    }
+}
+
+/**
+ * RetransmissionTimer::base_rto : RTO = SRTT + max(G, 4 * RTTVAR)，并限制在[min_rto, max_rto]内，
+ * 其中时钟粒度G为1ms。
+ * @param  initial_rto : 非自适应模式或尚无RTT样本时使用的RTO
+ * @return             : 计时器启动或重置时使用的RTO
+ */
+unsigned int RetransmissionTimer::base_rto(const unsigned int initial_rto) const {
+    if (!_adaptive || !_srtt.has_value()) {
+        return initial_rto;
+    }
+    double rto = _srtt.value() + max(1.0, 4 * _rttvar);
+    return min(max(static_cast<unsigned int>(ceil(rto)), _min_rto), _max_rto);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -2,13 +2,19 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "ring_deque.hh"
 #include "tcp_config.hh"
+#include "tcp_sack.hh"
 #include "tcp_segment.hh"
+#include "tcp_stats.hh"
+#include "timer_wheel.hh"
 #include "wrapping_integers.hh"
 
 #include <functional>
+#include <memory>
 #include <queue>
-#include <map>
+#include <vector>
 
 
 /**
@@ -25,6 +31,18 @@ private:
   // 计时器重传的次数，即RTO加倍的次数。
   unsigned int _consecutive_retx{0};
 
+  // RFC 6298 的平滑RTT与RTT偏差估计，收到第一个RTT样本之前为空
+  std::optional<double> _srtt{};
+  double _rttvar{0};
+
+  // 是否根据RTT估计计算RTO，以及RTO的上下界
+  bool _adaptive{false};
+  unsigned int _min_rto{0};
+  unsigned int _max_rto{0};
+
+  // 自适应模式下由RTT估计得到RTO，否则使用给定的初始RTO
+  unsigned int base_rto(const unsigned int initial_rto) const;
+
 public:
   // 启动重传计算器
   void start(const uint16_t initial_rto);
@@ -44,6 +62,48 @@ public:
   // 获取重传的次数
   unsigned int consecutive_retransmissions() const { return _consecutive_retx; }
 
+  // 启用自适应RTO，RTO被限制在[min_rto, max_rto]内
+  void enable_adaptive_rto(const unsigned int min_rto, const unsigned int max_rto);
+
+  // 加入一个RTT样本，更新SRTT与RTTVAR
+  void add_rtt_sample(const uint64_t rtt_ms);
+
+  // 获取平滑RTT，尚无样本时为空
+  std::optional<double> srtt() const { return _srtt; }
+
+  // 获取当前的RTO，计时器未启动时为空
+  std::optional<unsigned int> rto() const { return _rto; }
+
+};
+
+
+/**
+ * GSO大segment切分出的一段：与大segment共享同一块负载存储，只记录自己在负载中的区间，
+ * 切分时不复制负载。用writev发送的传输层可以直接发送header().serialize()与payload()。
+ */
+class SegmentPiece {
+private:
+  TCPHeader _header{};
+
+  // 与大segment共享的负载存储，以及本段在其中的区间
+  Buffer _storage{};
+  size_t _offset{0};
+  size_t _length{0};
+
+public:
+  SegmentPiece(const TCPHeader &header, const Buffer &storage, const size_t offset, const size_t length)
+    : _header(header), _storage(storage), _offset(offset), _length(length) {}
+
+  const TCPHeader &header() const { return _header; }
+  TCPHeader &header() { return _header; }
+
+  // 本段负载的视图，指向共享存储，在SegmentPiece存活期间有效
+  std::string_view payload() const { return _storage.str().substr(_offset, _length); }
+
+  size_t length_in_sequence_space() const { return _length + (_header.syn ? 1 : 0) + (_header.fin ? 1 : 0); }
+
+  // 转换成TCPSegment：区间延伸到负载末尾时仍共享存储，否则复制本段负载
+  TCPSegment segment() const;
 };
 
 
@@ -73,8 +133,43 @@ class TCPSender {
     // 重传计时器
     RetransmissionTimer _retransmission_timer{};
 
-    // 利用map自动排序的特性管理未被确认的segment
-    std::map<uint64_t, TCPSegment> _outstanding_segments{};
+    // 已发送但未被确认的segment及其绝对序号
+    struct OutstandingSegment {
+        uint64_t abs_seqno{0};
+        TCPSegment segment{};
+        uint64_t sent_time_ms{0};   // 首次发送的时间
+        bool retransmitted{false};  // 是否被重传过
+        bool sacked{false};         // 是否已被接收方SACK确认
+        bool lost{false};           // 被判定丢失、等待重传(有拥塞控制时的重传超时，或被SACK后又被接收方丢弃)
+    };
+
+    // 按序号从小到大排列的未确认segment队列，累积确认时只需从队首弹出。
+    // segment只在这里保存一份，发送与重传时放入_segments_out的是共享同一负载的副本
+    RingDeque<OutstandingSegment> _outstanding_segments{};
+
+    // 未确认且未被SACK的segment在序号空间中占用的总长度
+    uint64_t _bytes_in_flight{0};
+
+    // 已被SACK但尚未被累积确认的segment的总长度
+    uint64_t _sacked_bytes{0};
+
+    // 被判定丢失、等待重传的segment的总长度，这些数据已不在网络中，不计入在途字节数
+    uint64_t _lost_bytes{0};
+
+    // 判定丢包所需的重复确认数(RFC 5681/6675中的DupThresh)
+    static constexpr uint64_t DUP_THRESH = 3;
+
+    // 丢包恢复周期的结束点：进入恢复时的_next_seqno，不在恢复期间时为空
+    std::optional<uint64_t> _recovery_point{};
+
+    // 是否启用快速重传与快速恢复
+    bool _fast_retransmit{false};
+
+    // 连续收到的重复ACK数
+    uint64_t _dup_acks{0};
+
+    // 快速恢复期间拥塞窗口的膨胀量(字节)
+    uint64_t _recovery_inflation{0};
 
     // 上一次(最新)接收到的有效的ACK绝对序号，初始为0
     uint64_t _last_abs_ackno{0};
@@ -88,11 +183,88 @@ class TCPSender {
     // 记录FIN标志是否已经发送，用于防止重复地发送FIN。
     bool _fin_sent{false};
 
+    // 自创建以来经过tick累计的时间(ms)
+    uint64_t _time_elapsed{0};
+
+    // 拥塞控制算法，为空时发送窗口只受接收方窗口限制
+    std::unique_ptr<CongestionController> _congestion_controller{};
+
+    // 根据接收方窗口与拥塞窗口重新计算_remaining_window_size
+    void update_remaining_window();
+
+    // 处理接收方的SACK块，并重传被判定为丢失的空洞
+    void sack_received(const std::vector<SackBlock> &sack_blocks);
+
+    // 处理重复ACK，必要时快速重传并进入快速恢复
+    void duplicate_ack_received();
+
+    // 重传第一个未被SACK确认的outstanding segment，没有可重传的segment时返回false
+    bool retransmit_first_hole();
+
+    // 在拥塞窗口允许的范围内重传被判定丢失的segment，没有拥塞控制时只重传最早的一个
+    void retransmit_lost();
+
+    // GSO：每个segment最多携带的MSS个数，为1时每个segment不超过一个MSS
+    size_t _gso_segments{1};
+
+    // 接收方通告的窗口缩放位数(RFC 7323)，ACK中的窗口字段需左移此位数
+    uint8_t _peer_window_shift{0};
+
+    // 共享的时间轮，为空时由tick驱动重传计时器
+    std::shared_ptr<TimerWheel> _timer_wheel{};
+
+    // 当前在时间轮上设置的重传超时
+    std::optional<TimerWheel::TimerId> _rto_timer_id{};
+
+    // 重传计时器超时的处理
+    void retransmission_timeout();
+
+    // 有拥塞控制时，超时后把除第一个空洞外未被SACK的segment都标记为丢失
+    void mark_lost_after_timeout();
+
+    // 按重传计时器的当前状态在时间轮上重新设置超时
+    void rearm_timer_wheel();
+
+    // 发送方的时钟：设置了时间轮时为时间轮的时间，否则为tick累计的时间
+    uint64_t now_ms() const;
+
+    // 连接的统计计数器，与接收方共享，为空时不统计
+    std::shared_ptr<TCPStats> _stats{};
+
+    // 将segment放入_segments_out并计入统计
+    void send_segment(const TCPSegment &segment);
+
+    // 发送节奏控制(pacing)：新数据的发送受令牌桶限制，令牌(字节)按发送速率随时间补充；
+    // 发送一个segment只要求令牌为正，不足的部分记为欠额。令牌最多积累_pacing_burst个字节，
+    // 因此空闲、受窗口或应用限制之后不会形成大的突发；只受pacing限制期间流逝的时间全部计入，
+    // 即使两次补充相隔很久(tick间隔较长)也能维持发送速率
+    bool _pacing{false};
+    double _pacing_fixed_rate{0};  // 配置的发送速率(字节/ms)，为0时自动计算
+    size_t _pacing_burst{0};
+    double _pacing_tokens{0};
+    uint64_t _pacing_refilled_ms{0};
+    bool _pacing_limited{false};  // 上次fill_window结束时是否只因令牌耗尽而无法继续发送
+
+    // 令牌耗尽时在时间轮上设置的继续发送的计时器
+    std::optional<TimerWheel::TimerId> _pacing_timer_id{};
+
+    // 按流逝的时间补充令牌
+    void refill_pacing_tokens();
+
+    // 设置了时间轮时，在令牌重新变为正数时继续发送
+    void arm_pacing_timer();
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const bool chunked_stream = false);
+
+    //! \brief A sender registered with a TimerWheel is referenced by its callbacks, so it is neither copied nor moved
+    TCPSender(const TCPSender &) = delete;
+    TCPSender &operator=(const TCPSender &) = delete;
+    ~TCPSender();
 
     //! \name "Input" interface for the writer
     //!@{
@@ -104,7 +276,11 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \note `window_size` is the 16-bit window field, scaled by the peer's window shift
+    //! \note segments wholly covered by `sack_blocks` stop counting as in flight and are not retransmitted
+    void ack_received(const WrappingInt32 ackno,
+                      const uint16_t window_size,
+                      const std::vector<SackBlock> &sack_blocks = {});
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -116,22 +292,95 @@ class TCPSender {
     void tick(const size_t ms_since_last_tick);
     //!@}
 
+    //! \brief Install a congestion controller that is notified of ACKs and timeouts
+    void set_congestion_controller(std::unique_ptr<CongestionController> controller);
+
+    //! \brief Apply the window scale shift (RFC 7323) the peer offered in its SYN,
+    //! once both sides have agreed to scale; window fields in later ACKs are shifted left by it
+    void set_peer_window_shift(const uint8_t shift);
+
+    //! \brief Count sent segments, retransmissions, duplicate ACKs, zero windows and
+    //! window- vs application-limited time in `stats` (shared with the TCPReceiver)
+    //! \note The limited-time counters are sampled in tick()
+    void set_stats(std::shared_ptr<TCPStats> stats) { _stats = std::move(stats); }
+
+    //! \brief Let a shared TimerWheel fire this sender's retransmission timeouts
+    //! \note tick() keeps working and then only advances the sender's clock
+    void attach_timer_wheel(std::shared_ptr<TimerWheel> wheel);
+
+    //! \brief Retransmit the first outstanding segment on the third duplicate ACK
+    //! and keep sending during NewReno fast recovery (RFC 5681, RFC 6582)
+    void enable_fast_retransmit(const bool enable = true);
+
+    //! \brief Compute the RTO from measured RTTs (RFC 6298) instead of using the fixed initial value
+    //! \param min_rto lower bound of the RTO in milliseconds
+    //! \param max_rto upper bound of the RTO in milliseconds, also applied to exponential backoff
+    void enable_adaptive_rto(const unsigned int min_rto = 200, const unsigned int max_rto = 60000);
+
+    //! \brief Pace new data at a steady rate instead of sending a newly opened window back to back
+    //! \param rate_bps fixed pacing rate in bits per second; 0 derives it from the congestion controller's
+    //! own rate or from cwnd/SRTT (gain 2 in slow start, 1.2 after), or from the receiver's window/SRTT
+    //! without a controller. New data is sent unpaced until the first RTT sample.
+    //! \param burst_bytes how many bytes may leave back to back, e.g. after an idle period
+    //! \note Retransmissions are not paced. Segments held back are released by tick(), or by a timer
+    //! on the TimerWheel when one is attached.
+    void enable_pacing(const uint64_t rate_bps = 0, const size_t burst_bytes = 4 * TCPConfig::MAX_PAYLOAD_SIZE);
+
     //! \name Accessors
     //!@{
 
     //! \brief How many sequence numbers are occupied by segments sent but not yet acknowledged?
     //! \note count is in "sequence space," i.e. SYN and FIN each count for one byte
     //! (see TCPSegment::length_in_sequence_space())
+    //! \note segments selectively acknowledged by SACK are not counted; segments waiting to be
+    //! retransmitted because the receiver discarded them are
     size_t bytes_in_flight() const;
 
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Congestion window in bytes
+    //! \returns empty if no congestion controller is installed
+    std::optional<uint64_t> cwnd() const;
+
+    //! \brief Slow-start threshold in bytes
+    //! \returns empty if no congestion controller is installed
+    std::optional<uint64_t> ssthresh() const;
+
+    //! \brief Smoothed round-trip time in milliseconds
+    //! \returns empty until the first RTT sample has been taken
+    std::optional<double> srtt() const { return _retransmission_timer.srtt(); }
+
+    //! \brief Current retransmission timeout in milliseconds
+    //! \returns empty while the retransmission timer is not running
+    std::optional<unsigned int> rto() const { return _retransmission_timer.rto(); }
+
+    //! \brief Current pacing rate in bytes per millisecond
+    //! \returns empty if pacing is off, or the rate is derived and there is no RTT sample yet
+    std::optional<double> pacing_rate() const;
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
     //! (ackno and window size) before sending.
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
+
+    //! \brief Move up to `max_segments` enqueued segments into `batch` in one call
+    size_t segments_out_batch(std::vector<TCPSegment> &batch, const size_t max_segments);
+    //!@}
+
+    //! \name Generic segmentation offload
+    //!@{
+
+    //! \brief Let fill_window() build "super-segments" carrying up to `max_segments` MSS-sized pieces
+    //! \note The outstanding queue tracks each super-segment as one entry; partial ACKs trim it,
+    //! and the transport must pass every outgoing segment through split_segment()
+    void enable_gso(const size_t max_segments);
+
+    //! \brief Split a segment into pieces whose payloads are at most `mss` bytes
+    //! \note The pieces share the segment's payload storage; no payload bytes are copied
+    static std::vector<SegmentPiece> split_segment(const TCPSegment &segment,
+                                                   const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE);
     //!@}
 
     //! \name What is the next sequence number? (used for testing)
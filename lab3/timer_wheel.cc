@@ -0,0 +1,85 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * TimerWheel::arm : 设置定时器。
+ * @param  delay_ms : 距离到期的时间，为0时视为1ms，即在下一次advance时到期
+ * @param  callback : 到期时调用的回调函数
+ * @return          : 定时器ID，用于取消定时器
+ */
+TimerWheel::TimerId TimerWheel::arm(const uint64_t delay_ms, Callback callback) {
+    TimerId id = _next_id++;
+    place({id, _now_ms + max<uint64_t>(delay_ms, 1), move(callback)});
+    return id;
+}
+
+/**
+ * TimerWheel::cancel : 取消定时器。
+ * @param  id : 定时器ID
+ * @return    : 定时器尚未到期并被取消时返回true
+ */
+bool TimerWheel::cancel(const TimerId id) {
+    auto location = _locations.find(id);
+    if (location == _locations.end()) {
+        return false;
+    }
+    location->second.slot->erase(location->second.it);
+    _locations.erase(location);
+    return true;
+}
+
+/**
+ * TimerWheel::advance : 逐毫秒推进时间。每一毫秒先在低层槽转完一圈时逐层下放高层槽中的定时器，
+ * 再触发第0层当前槽中的全部定时器；没有定时器时直接跳到目标时间。
+ * @param ms : 推进的时间
+ */
+void TimerWheel::advance(const uint64_t ms) {
+    uint64_t target_ms = _now_ms + ms;
+    while (_now_ms < target_ms) {
+        if (_locations.empty()) {
+            _now_ms = target_ms;
+            break;
+        }
+        ++_now_ms;
+        for (unsigned int level = 1; level < LEVELS; ++level) {
+            if (((_now_ms >> (SLOT_BITS * (level - 1))) & (SLOTS - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        /* 回调函数可能设置或取消其他定时器，因此每次只从槽中取出一个 */
+        Slot &slot = _wheels[0][_now_ms & (SLOTS - 1)];
+        while (!slot.empty()) {
+            Timer timer = move(slot.front());
+            slot.pop_front();
+            _locations.erase(timer.id);
+            timer.callback();
+        }
+    }
+}
+
+void TimerWheel::place(Timer &&timer) {
+    uint64_t distance = timer.deadline_ms - _now_ms;
+    unsigned int level = 0;
+    while ((level < LEVELS - 1) && (distance >= (1ull << (SLOT_BITS * (level + 1))))) {
+        ++level;
+    }
+    Slot &slot = _wheels[level][(timer.deadline_ms >> (SLOT_BITS * level)) & (SLOTS - 1)];
+    TimerId id = timer.id;
+    slot.push_back(move(timer));
+    _locations.insert_or_assign(id, Location{&slot, prev(slot.end())});
+}
+
+void TimerWheel::cascade(const unsigned int level) {
+    Slot pending;
+    pending.swap(_wheels[level][(_now_ms >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+    while (!pending.empty()) {
+        Timer timer = move(pending.front());
+        pending.pop_front();
+        place(move(timer));
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+/**
+ * 分层时间轮：以1ms为精度，共LEVELS层、每层SLOTS个槽，覆盖2^32ms的超时时间。
+ * 第i层的一个槽对应SLOTS^i毫秒，定时器按到期时间与当前时间的距离放入对应层的槽中，
+ * 低层槽转完一圈时把高层对应槽中的定时器重新分配到低层。arm/cancel均为O(1)，
+ * advance只会访问已到期或需要下放的定时器，大量空闲连接不会带来额外开销。
+ */
+class TimerWheel {
+public:
+  using TimerId = uint64_t;
+  using Callback = std::function<void()>;
+
+private:
+  static constexpr unsigned int LEVELS = 4;
+  static constexpr unsigned int SLOT_BITS = 8;
+  static constexpr uint64_t SLOTS = 1ull << SLOT_BITS;
+
+  struct Timer {
+    TimerId id;
+    uint64_t deadline_ms;
+    Callback callback;
+  };
+
+  using Slot = std::list<Timer>;
+
+  // 定时器所在的槽及其在槽中的位置，用于O(1)取消
+  struct Location {
+    Slot *slot;
+    Slot::iterator it;
+  };
+
+  std::array<std::array<Slot, SLOTS>, LEVELS> _wheels{};
+  std::unordered_map<TimerId, Location> _locations{};
+
+  // 时间轮的当前时间(ms)
+  uint64_t _now_ms{0};
+
+  // 下一个分配的定时器ID
+  TimerId _next_id{1};
+
+  // 将定时器放入到期时间对应的槽中
+  void place(Timer &&timer);
+
+  // 将第level层当前的槽中的定时器重新分配到更低的层
+  void cascade(const unsigned int level);
+
+public:
+  TimerWheel() = default;
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  // 设置一个delay_ms毫秒后(至少1ms)到期的定时器，返回其ID
+  TimerId arm(const uint64_t delay_ms, Callback callback);
+
+  // 取消定时器，定时器已到期或不存在时返回false
+  bool cancel(const TimerId id);
+
+  // 时间前进ms毫秒，依次调用到期定时器的回调函数
+  void advance(const uint64_t ms);
+
+  // 获取时间轮的当前时间
+  uint64_t now() const { return _now_ms; }
+
+  // 获取尚未到期的定时器数量
+  size_t size() const { return _locations.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
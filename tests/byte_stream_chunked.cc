@@ -0,0 +1,80 @@
+#include "byte_stream.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// 分块模式的ByteStream：写入的string与Buffer原样保存，整块读出时交出同一块存储而不拷贝；
+// 跨块或部分读出、容量截断与普通模式的语义相同
+
+static void test_whole_chunks_shared() {
+    ByteStream stream(1000, true);
+    Buffer first(string(300, 'a'));
+    const char *first_data = first.str().data();
+    test_should_be(stream.write(first), 300u);
+
+    string second(200, 'b');
+    const char *second_data = second.data();
+    test_should_be(stream.write(move(second)), 200u);
+
+    // 整块读出：与写入方共享存储
+    Buffer out = stream.read_buffer(1000);
+    test_should_be(out.size(), 300u);
+    test_should_hold(out.str().data() == first_data);
+    out = stream.read_buffer(200);
+    test_should_be(out.size(), 200u);
+    test_should_hold(out.str().data() == second_data);
+    test_should_hold(stream.buffer_empty());
+    test_should_be(stream.bytes_read(), 500u);
+}
+
+static void test_partial_reads() {
+    ByteStream stream(1000, true);
+    stream.write(string("hello "));
+    stream.write(string("chunked "));
+    stream.write(string("world"));
+
+    // peek_views给出前两块
+    const auto views = stream.peek_views(100);
+    test_should_be(views.first, "hello ");
+    test_should_be(views.second, "chunked ");
+    test_should_be(stream.peek_output(10), "hello chun");
+
+    // 跨块读出拷贝数据；读出一块的一部分只去除它的前缀
+    test_should_be(stream.read(8), "hello ch");
+    test_should_be(stream.read_buffer(3).str(), "unk");
+    test_should_be(stream.read_buffer(100).str(), "ed ");
+    stream.end_input();
+    test_should_be(stream.read(100), "world");
+    test_should_hold(stream.eof());
+}
+
+static void test_capacity() {
+    ByteStream stream(10, true);
+    test_should_be(stream.write(string("abcdef")), 6u);
+    test_should_be(stream.write(Buffer(string("ghijklmn"))), 4u);
+    test_should_be(stream.remaining_capacity(), 0u);
+    test_should_be(stream.write(string("x")), 0u);
+    test_should_be(stream.read(10), "abcdefghij");
+    test_should_be(stream.write(string("")), 0u);
+    stream.end_input();
+    test_should_be(stream.write(string("late")), 0u);
+    test_should_hold(stream.eof());
+    test_should_be(stream.bytes_written(), 10u);
+}
+
+int main() {
+    try {
+        test_whole_chunks_shared();
+        test_partial_reads();
+        test_capacity();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "byte_stream.hh"
+#include "test_should_be.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// 并发模式的ByteStream：一个写线程与一个读线程不加锁地共享流，写满时等待空间、读空时等待数据，
+// 读到的字节与写入的顺序一致并正确结束；set_error()唤醒阻塞的读者
+
+static char byte_at(const size_t index) { return static_cast<char>((index * 131) ^ (index >> 9)); }
+
+static void test_transfer(const size_t capacity, const size_t total) {
+    ByteStream stream(capacity);
+    stream.make_concurrent();
+    bool reader_failed = false;
+
+    thread writer([&] {
+        mt19937 rng(1);
+        string piece;
+        size_t written = 0;
+        while (written < total) {
+            piece.resize(min<size_t>(1 + rng() % (2 * capacity), total - written));
+            for (size_t i = 0; i < piece.size(); ++i) {
+                piece[i] = byte_at(written + i);
+            }
+            const size_t accepted = stream.write(piece);
+            written += accepted;
+            if (accepted < piece.size()) {
+                stream.wait_writable();
+            }
+        }
+        stream.end_input();
+    });
+
+    // 交替使用read()与peek_views()/pop_output()
+    mt19937 rng(2);
+    size_t read = 0;
+    while (!stream.eof()) {
+        if (stream.buffer_empty()) {
+            stream.wait_readable();
+            continue;
+        }
+        const size_t len = 1 + rng() % capacity;
+        if (rng() % 2 == 0) {
+            const string bytes = stream.read(len);
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                reader_failed = reader_failed || (bytes[i] != byte_at(read + i));
+            }
+            read += bytes.size();
+        } else {
+            const auto views = stream.peek_views(len);
+            size_t offset = 0;
+            for (const string_view view : {views.first, views.second}) {
+                for (const char c : view) {
+                    reader_failed = reader_failed || (c != byte_at(read + offset++));
+                }
+            }
+            stream.pop_output(offset);
+            read += offset;
+        }
+    }
+    writer.join();
+
+    test_should_hold(!reader_failed);
+    test_should_be(read, total);
+    test_should_be(stream.bytes_written(), total);
+    test_should_be(stream.bytes_read(), total);
+}
+
+static void test_error_wakes_reader() {
+    ByteStream stream(100);
+    stream.make_concurrent();
+    atomic<bool> woken{false};
+    thread reader([&] {
+        stream.wait_readable();
+        woken = true;
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    test_should_hold(!woken);
+    stream.set_error();
+    reader.join();
+    test_should_hold(woken);
+    test_should_hold(stream.error());
+}
+
+int main() {
+    try {
+        test_transfer(1000, 4 << 20);
+        test_transfer(1 << 16, 32 << 20);
+        test_error_wakes_reader();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
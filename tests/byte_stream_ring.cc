@@ -0,0 +1,144 @@
+#include "byte_stream.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+// 环形缓冲区的ByteStream：环绕时peek_views给出两段视图，容量超过初始环长度时环按需增长，
+// 与一个简单的std::string模型在随机读写下保持一致；流可以移动，并发模式下不能移动
+
+static string concat(const pair<string_view, string_view> &views) {
+    return string(views.first) + string(views.second);
+}
+
+static void test_wraparound_views() {
+    ByteStream stream(10);
+    test_should_be(stream.write("abcdefgh"), 8u);
+    test_should_be(stream.read(5), "abcde");
+    test_should_be(stream.write("ijklmnopq"), 7u);
+    test_should_be(stream.remaining_capacity(), 0u);
+
+    // 环长度为capacity向上取整的2的幂(16)，此时数据跨过环尾
+    const auto views = stream.peek_views(10);
+    test_should_be(concat(views), "fghijklmno");
+    test_should_be(views.first.size() + views.second.size(), 10u);
+    test_should_be(concat(stream.peek_views(4)), "fghi");
+    test_should_be(stream.peek_output(10), "fghijklmno");
+
+    stream.pop_output(3);
+    test_should_be(concat(stream.peek_views(100)), "ijklmno");
+    stream.end_input();
+    test_should_hold(!stream.eof());
+    test_should_be(stream.read(100), "ijklmno");
+    test_should_hold(stream.eof());
+    test_should_be(stream.bytes_written(), 15u);
+    test_should_be(stream.bytes_read(), 15u);
+}
+
+static void test_growth() {
+    // 容量远大于初始环长度：写入时环倍增，已缓存的数据(包括跨过环尾的部分)保持顺序
+    constexpr size_t CAPACITY = 1 << 20;
+    ByteStream stream(CAPACITY);
+    string model;
+    size_t next = 0;
+    const auto produce = [&next](const size_t length) {
+        string data(length, '\0');
+        for (char &c : data) {
+            c = static_cast<char>('a' + next++ % 26);
+        }
+        return data;
+    };
+    for (size_t round = 0; round < 8; ++round) {
+        const string data = produce(100'000);
+        test_should_be(stream.write(data), data.size());
+        model += data;
+        const string out = stream.read(30'000);
+        test_should_be(out, model.substr(0, out.size()));
+        model.erase(0, out.size());
+    }
+    test_should_be(stream.buffer_size(), model.size());
+    test_should_be(stream.remaining_capacity(), CAPACITY - model.size());
+    test_should_be(concat(stream.peek_views(model.size())), model);
+    test_should_be(stream.read(model.size()), model);
+}
+
+static void test_random_against_model() {
+    mt19937 rng(1);
+    for (const size_t capacity : {1, 7, 64, 1000, 100'000}) {
+        ByteStream stream(capacity);
+        string model;
+        size_t written = 0;
+        for (size_t op = 0; op < 20'000; ++op) {
+            if (rng() % 2 == 0) {
+                string data(rng() % (2 * capacity + 1), static_cast<char>('a' + op % 26));
+                const size_t accepted = stream.write(data);
+                test_should_be(accepted, min(data.size(), capacity - model.size()));
+                model += data.substr(0, accepted);
+                written += accepted;
+            } else {
+                const size_t length = rng() % (capacity + 1);
+                test_should_be(concat(stream.peek_views(length)), model.substr(0, length));
+                test_should_be(stream.read(length), model.substr(0, length));
+                model.erase(0, min(length, model.size()));
+            }
+            test_should_be(stream.buffer_size(), model.size());
+            test_should_be(stream.bytes_written(), written);
+        }
+    }
+}
+
+static_assert(is_move_constructible_v<ByteStream> && is_move_assignable_v<ByteStream>);
+
+static void test_move() {
+    ByteStream stream(10);
+    stream.write("abcdefgh");
+    stream.pop_output(6);
+    stream.write("ijklmn");  // 环绕
+    ByteStream moved(move(stream));
+    test_should_be(concat(moved.peek_views(10)), string("ghijklmn"));
+    test_should_be(moved.bytes_written(), 14u);
+    test_should_be(moved.remaining_capacity(), 2u);
+
+    // 被移动的流是一个空流，仍可使用
+    test_should_be(stream.buffer_size(), 0u);
+    test_should_be(stream.write("xyz"), 3u);
+    test_should_be(stream.read(3), string("xyz"));
+
+    ByteStream chunked(10, true);
+    chunked.write(string("abc"));
+    chunked.end_input();
+    moved = move(chunked);
+    test_should_be(moved.read(10), string("abc"));
+    test_should_hold(moved.eof());
+
+    ByteStream concurrent(10);
+    concurrent.make_concurrent();
+    bool thrown = false;
+    try {
+        ByteStream other(move(concurrent));
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    test_should_hold(thrown);
+}
+
+int main() {
+    try {
+        test_wraparound_views();
+        test_growth();
+        test_random_against_model();
+        test_move();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include "byte_stream.hh"
+#include "spill_ring.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+using namespace std;
+
+// 溢出到磁盘：SpillRing在随机的写入、查看与弹出下与字符串模型一致，备份文件创建后即被删除；
+// 开启溢出的ByteStream内存中最多保留阈值字节，其余写入映射文件，读出的数据与写入的顺序一致
+
+static size_t directory_entries(const string &directory) {
+    size_t entries = 0;
+    DIR *dir = opendir(directory.c_str());
+    while (readdir(dir) != nullptr) {
+        ++entries;
+    }
+    closedir(dir);
+    return entries;
+}
+
+static void test_spill_ring(const string &directory) {
+    const size_t entries = directory_entries(directory);
+    SpillRing ring(directory, 4096);
+    test_should_be(directory_entries(directory), entries);
+
+    mt19937 rng(22);
+    string model;
+    for (size_t round = 0; round < 5000; ++round) {
+        switch (rng() % 4) {
+            case 0:
+            case 1: {
+                string data(rng() % 10000, '\0');
+                for (char &c : data) {
+                    c = static_cast<char>(rng());
+                }
+                ring.write(data);
+                model += data;
+                break;
+            }
+            case 2: {
+                const size_t len = rng() % 10000;
+                const auto views = ring.peek_views(len);
+                test_should_hold(views.first.size() + views.second.size() <= min(len, model.size()));
+                test_should_hold(model.compare(0, views.first.size(), views.first) == 0);
+                test_should_hold(model.compare(views.first.size(), views.second.size(), views.second) == 0);
+                string out;
+                ring.append_to(out, len);
+                test_should_hold(out == model.substr(0, len));
+                break;
+            }
+            default: {
+                const size_t len = min<size_t>(rng() % 12000, model.size());
+                ring.pop(len);
+                model.erase(0, len);
+                break;
+            }
+        }
+        test_should_be(ring.size(), model.size());
+    }
+    ring.pop(ring.size());
+    test_should_hold(ring.empty());
+}
+
+static void test_spilling_stream(const string &directory) {
+    constexpr size_t THRESHOLD = 64 << 10;
+    constexpr size_t TOTAL = 8 << 20;
+    ByteStream stream(64 << 20);
+    stream.enable_spill(directory, THRESHOLD, 16 << 10);
+
+    mt19937 rng(23);
+    string data(TOTAL, '\0');
+    for (char &c : data) {
+        c = static_cast<char>(rng());
+    }
+    size_t written = 0;
+    size_t read = 0;
+    size_t peak_spilled = 0;
+    while (read < TOTAL) {
+        // 写入远快于读取，积压的数据大部分溢出到文件
+        for (size_t i = 0; i < 3 && written < TOTAL; ++i) {
+            const size_t len = min<size_t>(1 + rng() % 20000, TOTAL - written);
+            test_should_be(stream.write(string_view(data).substr(written, len)), len);
+            written += len;
+        }
+        if (written == TOTAL && !stream.input_ended()) {
+            stream.end_input();
+        }
+        test_should_hold(stream.buffer_size() - stream.spilled_bytes() <= THRESHOLD);
+        peak_spilled = max(peak_spilled, stream.spilled_bytes());
+
+        const size_t len = 1 + rng() % 30000;
+        string out;
+        if (rng() % 2 == 0) {
+            out = stream.read(len);
+        } else {
+            const string peeked = stream.peek_output(len);
+            const auto views = stream.peek_views(len);
+            test_should_hold(peeked.compare(0, views.first.size(), views.first) == 0);
+            stream.pop_output(peeked.size());
+            out = peeked;
+        }
+        test_should_hold(data.compare(read, out.size(), out) == 0);
+        read += out.size();
+    }
+    test_should_hold(peak_spilled > TOTAL / 4);
+    test_should_hold(stream.eof());
+    test_should_be(stream.spilled_bytes(), 0u);
+    test_should_be(stream.bytes_read(), TOTAL);
+}
+
+int main() {
+    try {
+        char directory[] = "/tmp/byte_stream_spill.XXXXXX";
+        if (mkdtemp(directory) == nullptr) {
+            throw runtime_error("mkdtemp failed");
+        }
+        test_spill_ring(directory);
+        test_spilling_stream(directory);
+        test_should_be(directory_entries(directory), 2u);  // 只有.与..
+        rmdir(directory);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
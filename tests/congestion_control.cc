@@ -0,0 +1,144 @@
+#include "congestion_controller.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// 拥塞控制算法：NewReno的慢启动、拥塞避免与丢包/超时后的窗口，CUBIC丢包后的乘性减与回到W_max的增长，
+// BBR的带宽与最小RTT估计；以及安装了拥塞控制的发送方超时后按拥塞窗口依次重传其余未确认的数据
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static void test_newreno() {
+    NewRenoController reno(MSS, 10);
+    test_should_be(reno.cwnd(), 10 * MSS);
+
+    // 慢启动：每个ACK增加min(确认字节数, MSS)
+    reno.on_ack({0, MSS, 0, 10});
+    test_should_be(reno.cwnd(), 11 * MSS);
+    reno.on_ack({0, 5 * MSS, 0, 10});
+    test_should_be(reno.cwnd(), 12 * MSS);
+
+    // 丢包：ssthresh与cwnd降为在途字节数的一半，之后每确认一个cwnd的数据增加一个MSS
+    reno.on_loss(0, 12 * MSS);
+    test_should_be(reno.cwnd(), 6 * MSS);
+    test_should_be(reno.ssthresh(), 6 * MSS);
+    for (int i = 0; i < 5; ++i) {
+        reno.on_ack({0, MSS, 0, 10});
+    }
+    test_should_be(reno.cwnd(), 6 * MSS);
+    reno.on_ack({0, MSS, 0, 10});
+    test_should_be(reno.cwnd(), 7 * MSS);
+
+    // 超时：cwnd回到一个MSS，ssthresh不低于两个MSS
+    reno.on_timeout(0, 2 * MSS);
+    test_should_be(reno.cwnd(), MSS);
+    test_should_be(reno.ssthresh(), 2 * MSS);
+}
+
+static void test_cubic() {
+    CubicController cubic(MSS, 100);
+    cubic.on_loss(0, 100 * MSS);
+    test_should_be(cubic.cwnd(), 70 * MSS);
+
+    // 拥塞避免：窗口先快速增长，在W_max附近放缓，K秒后回到W_max，之后越过它继续探测
+    uint64_t now = 0;
+    uint64_t cwnd_at_wmax = 0;
+    while (now < 10'000) {
+        now += 10;
+        cubic.on_ack({now, cubic.cwnd(), 0, 10});
+        if (cwnd_at_wmax == 0 && cubic.cwnd() >= 100 * MSS) {
+            cwnd_at_wmax = now;
+        }
+    }
+    test_should_hold(cwnd_at_wmax > 0);
+    test_should_hold(cubic.cwnd() > 100 * MSS);
+
+    // 超时：cwnd回到一个MSS，ssthresh为超时前窗口的0.7倍
+    const uint64_t before = cubic.cwnd();
+    cubic.on_timeout(now, before);
+    test_should_be(cubic.cwnd(), MSS);
+    test_should_be(cubic.ssthresh(), static_cast<uint64_t>(before * 0.7));
+}
+
+static void test_bbr() {
+    // 瓶颈带宽100字节/ms，RTT 20ms：每ms确认100字节
+    BBRController bbr(MSS, 10);
+    for (uint64_t now = 1; now <= 2000; ++now) {
+        bbr.on_ack({now, 100, 0, 20});
+    }
+    test_should_hold(bbr.bottleneck_bandwidth() > 95 && bbr.bottleneck_bandwidth() < 105);
+    test_should_be(bbr.min_rtt().value(), 20u);
+
+    // 带宽不再增长，已离开STARTUP：窗口为2倍BDP(不少于4个MSS)，发送速率略高于带宽估计
+    test_should_hold(bbr.ssthresh() != UINT64_MAX);
+    test_should_be(bbr.cwnd(), max<uint64_t>(static_cast<uint64_t>(2.0 * bbr.bottleneck_bandwidth() * 20), 4 * MSS));
+    test_should_hold(bbr.pacing_rate().value() > bbr.bottleneck_bandwidth());
+
+    // 丢包不直接减小窗口，超时回到一个MSS
+    const uint64_t cwnd = bbr.cwnd();
+    bbr.on_loss(2000, cwnd);
+    test_should_be(bbr.cwnd(), cwnd);
+    bbr.on_timeout(2000, cwnd);
+    test_should_be(bbr.cwnd(), MSS);
+}
+
+//! \returns 取出的segment数，first为其中第一个segment的相对序号
+static size_t drain(TCPSender &sender, uint32_t *first = nullptr) {
+    size_t count = 0;
+    while (!sender.segments_out().empty()) {
+        if (first != nullptr && count == 0) {
+            *first = sender.segments_out().front().header().seqno.raw_value();
+        }
+        sender.segments_out().pop();
+        ++count;
+    }
+    return count;
+}
+
+static void test_timeout_recovery() {
+    constexpr uint16_t RTO = 1000;
+    TCPSender sender(1 << 20, RTO, WrappingInt32{0});
+    sender.set_congestion_controller(make_unique<NewRenoController>());
+    sender.fill_window();
+    drain(sender);
+    sender.ack_received(WrappingInt32{1}, UINT16_MAX);
+    sender.stream_in().write(string(10 * MSS, 'x'));
+    sender.fill_window();
+    test_should_be(drain(sender), 10u);
+
+    // 超时：cwnd回到一个MSS，只重传第一个segment，其余的视为丢失但仍未被确认
+    sender.tick(RTO);
+    uint32_t seqno = 0;
+    test_should_be(drain(sender, &seqno), 1u);
+    test_should_be(seqno, 1u);
+    test_should_be(sender.bytes_in_flight(), 10 * MSS);
+
+    // 每个ACK使慢启动中的cwnd增加一个MSS，丢失的segment随之依次重传，不必各等一次超时
+    sender.ack_received(WrappingInt32{static_cast<uint32_t>(1 + MSS)}, UINT16_MAX);
+    test_should_be(drain(sender, &seqno), 2u);
+    test_should_be(seqno, 1 + MSS);
+    sender.ack_received(WrappingInt32{static_cast<uint32_t>(1 + 3 * MSS)}, UINT16_MAX);
+    test_should_be(drain(sender, &seqno), 3u);
+    test_should_be(seqno, 1 + 3 * MSS);
+    test_should_be(sender.bytes_in_flight(), 7 * MSS);
+}
+
+int main() {
+    try {
+        test_newreno();
+        test_cubic();
+        test_bbr();
+        test_timeout_recovery();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+// webget并发抓取模式的本地替身服务器：监听127.0.0.1上的一个临时端口并把端口号打印到标准输出，
+// 每条连接一个线程，按顺序回应流水线式发来的GET请求。响应体由路径决定，可以完全复现：
+//   /bytes/N    Content-Length为N的响应体
+//   /chunked/N  以4096字节一块的chunked编码发送N字节
+//   /early/N    先发送100 Continue与103 Early Hints两个临时响应，再发送N字节的响应体
+// 选项：--max-requests K  每条连接回应K个请求后关闭(第K个响应带Connection: close)
+//       --cut-every K     每条连接的第K个响应只发送一半响应体就关闭连接
+//       --body PATH       不启动服务器，把PATH的响应体打印到标准输出(用于生成期望的输出)
+
+struct Options {
+    size_t max_requests{0};
+    size_t cut_every{0};
+};
+
+static void write_all(const int fd, string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error(string("send: ") + strerror(errno));
+        }
+        data.remove_prefix(written);
+    }
+}
+
+//! \returns bytes [offset, offset + length) of the body for `path`
+static string body_bytes(const string &path, const size_t offset, const size_t length) {
+    size_t seed = 0;
+    for (const char c : path) {
+        seed = seed * 31 + static_cast<unsigned char>(c);
+    }
+    string bytes(length, '\0');
+    for (size_t i = 0; i < length; ++i) {
+        bytes[i] = static_cast<char>('a' + (seed + offset + i) % 26);
+    }
+    return bytes;
+}
+
+static size_t body_size(const string &path) {
+    size_t slash = path.rfind('/');
+    return (slash == string::npos) ? 0 : strtoull(path.c_str() + slash + 1, nullptr, 10);
+}
+
+//! \returns false if the connection was cut off on purpose
+static bool respond(const int fd, const string &path, const bool last, const bool cut) {
+    static constexpr size_t PIECE = 65536;
+    const size_t size = body_size(path);
+    const size_t sent_size = cut ? size / 2 : size;
+    const string connection = last ? "Connection: close\r\n" : "";
+
+    if (path.rfind("/early/", 0) == 0) {
+        write_all(fd, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 103 Early Hints\r\nLink: </style.css>\r\n\r\n");
+    }
+    if (path.rfind("/chunked/", 0) == 0) {
+        write_all(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n" + connection + "\r\n");
+        for (size_t offset = 0; offset < sent_size; offset += 4096) {
+            const size_t length = min<size_t>(4096, sent_size - offset);
+            char size_line[32];
+            snprintf(size_line, sizeof(size_line), "%zx\r\n", length);
+            write_all(fd, size_line + body_bytes(path, offset, length) + "\r\n");
+        }
+        if (!cut) {
+            write_all(fd, "0\r\n\r\n");
+        }
+    } else {
+        write_all(fd, "HTTP/1.1 200 OK\r\nContent-Length: " + to_string(size) + "\r\n" + connection + "\r\n");
+        for (size_t offset = 0; offset < sent_size; offset += PIECE) {
+            write_all(fd, body_bytes(path, offset, min(PIECE, sent_size - offset)));
+        }
+    }
+    return !cut;
+}
+
+static void serve(const int fd, const Options options) {
+    try {
+        string requests;
+        size_t responses = 0;
+        char buffer[4096];
+        while (true) {
+            size_t end = requests.find("\r\n\r\n");
+            if (end == string::npos) {
+                ssize_t bytes_read = ::read(fd, buffer, sizeof(buffer));
+                if (bytes_read <= 0) {
+                    break;
+                }
+                requests.append(buffer, bytes_read);
+                continue;
+            }
+            const string request = requests.substr(0, end);
+            requests.erase(0, end + 4);
+            const size_t path_start = request.find(' ') + 1;
+            const string path = request.substr(path_start, request.find(' ', path_start) - path_start);
+            ++responses;
+            const bool last = (options.max_requests > 0) && (responses == options.max_requests);
+            const bool cut = (options.cut_every > 0) && (responses % options.cut_every == 0);
+            if (!respond(fd, path, last, cut) || last) {
+                break;
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+    }
+    ::close(fd);
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const string arg = argv[i];
+            if (arg == "--body" && i + 1 < argc) {
+                const string path = argv[i + 1];
+                cout << body_bytes(path, 0, body_size(path));
+                return EXIT_SUCCESS;
+            } else if (arg == "--max-requests" && i + 1 < argc) {
+                options.max_requests = strtoull(argv[++i], nullptr, 10);
+            } else if (arg == "--cut-every" && i + 1 < argc) {
+                options.cut_every = strtoull(argv[++i], nullptr, 10);
+            } else {
+                cerr << "Usage: " << argv[0] << " [--max-requests K] [--cut-every K] | --body PATH\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr *>(&address), length) < 0 ||
+            ::listen(listener, 128) < 0 ||
+            ::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) < 0) {
+            throw runtime_error(string("listen: ") + strerror(errno));
+        }
+        cout << ntohs(address.sin_port) << endl;
+
+        while (true) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw runtime_error(string("accept: ") + strerror(errno));
+            }
+            thread(serve, fd, options).detach();
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,105 @@
+#include "congestion_controller.hh"
+#include "link_simulator.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// 链路模拟器：单条链路按带宽串行发送、经传播时延到达，队列满时丢弃新包；端到端传输在无损链路上
+// 接近链路带宽，在有丢包、乱序与重复的链路上仍能完成，并且相同的种子得到完全相同的结果
+
+static void test_link() {
+    mt19937_64 rng(1);
+    LinkConfig config;
+    config.bandwidth_bps = 8'000'000;  // 每微秒1字节
+    config.delay_ms = 10;
+    config.queue_bytes = 2500;
+    Link link(config, rng);
+
+    vector<uint64_t> arrivals;
+    uint64_t now_us = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        link.send(0, 1000, [&arrivals, &now_us] { arrivals.push_back(now_us); });
+    }
+    test_should_be(link.dropped(), 1u);  // 第三个包超出了队列长度
+
+    // 第二个包在第一个发送完后才开始发送
+    for (now_us = 0; now_us <= 20000; ++now_us) {
+        link.advance(now_us);
+    }
+    test_should_be(arrivals.size(), 2u);
+    test_should_be(arrivals[0], 11000u);
+    test_should_be(arrivals[1], 12000u);
+
+    // 队列排空后可以再次发送
+    link.send(now_us, 1000, [] {});
+    test_should_be(link.dropped(), 1u);
+}
+
+static TransferReport transfer(const LinkConfig &forward, const LinkConfig &reverse, const uint64_t seed) {
+    TCPSender sender(64000, 1000, WrappingInt32{0});
+    TCPReceiver receiver(64000);
+    sender.set_congestion_controller(make_unique<NewRenoController>());
+    sender.enable_fast_retransmit();
+    sender.enable_adaptive_rto();
+    LinkSimulator simulator(sender, receiver, forward, reverse, seed);
+    simulator.enable_sack();
+    TransferReport report = simulator.run(1'000'000);
+    test_should_hold(report.completed);
+    test_should_be(receiver.stream_out().bytes_read(), 1'000'000u);
+    return report;
+}
+
+int main() {
+    try {
+        test_link();
+
+        // 无损链路：BDP(10Mbit/s * 40ms = 50KB)小于窗口，吞吐量接近带宽
+        LinkConfig forward;
+        forward.bandwidth_bps = 10'000'000;
+        forward.delay_ms = 20;
+        LinkConfig reverse = forward;
+        const TransferReport clean = transfer(forward, reverse, 1);
+        test_should_be(clean.retransmissions, 0u);
+        test_should_be(clean.forward_drops, 0u);
+        test_should_hold(clean.goodput_bps <= forward.bandwidth_bps);
+        test_should_hold(clean.goodput_bps > 0.8 * forward.bandwidth_bps);
+        test_should_hold(clean.latency_p50_ms >= forward.delay_ms);
+        test_should_hold(clean.latency_p50_ms <= clean.latency_p99_ms);
+        test_should_hold(clean.latency_p99_ms <= clean.latency_max_ms);
+
+        // 有损链路：随机与突发丢包、乱序、重复，ACK也会丢失
+        forward.loss_rate = 0.02;
+        forward.burst_enter_rate = 0.005;
+        forward.burst_exit_rate = 0.3;
+        forward.reorder_rate = 0.05;
+        forward.reorder_delay_ms = 5;
+        forward.duplicate_rate = 0.01;
+        reverse.loss_rate = 0.02;
+        const TransferReport lossy = transfer(forward, reverse, 7);
+        test_should_hold(lossy.forward_drops > 0);
+        test_should_hold(lossy.reverse_drops > 0);
+        test_should_hold(lossy.retransmissions > 0);
+        test_should_hold(lossy.completion_ms > clean.completion_ms);
+
+        // 相同的种子得到完全相同的结果
+        const TransferReport again = transfer(forward, reverse, 7);
+        test_should_be(again.completion_ms, lossy.completion_ms);
+        test_should_be(again.segments_sent, lossy.segments_sent);
+        test_should_be(again.retransmissions, lossy.retransmissions);
+        test_should_be(again.acks_sent, lossy.acks_sent);
+        test_should_be(again.forward_drops, lossy.forward_drops);
+        test_should_be(again.reverse_drops, lossy.reverse_drops);
+        test_should_be(again.latency_p99_ms, lossy.latency_p99_ms);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include "reassembly_memory_pool.hh"
+#include "stream_reassembler.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// 两个重组器共享一个乱序数据内存池：池持有的字节(及其峰值)不超过上限，修剪从乱序数据延伸得最远的流
+// 的末尾开始；被修剪的字节重传后仍能正确重组；移动重组器时池中的引用随之转移
+
+static string stream_bytes(const size_t seed, const size_t length) {
+    string bytes(length, '\0');
+    for (size_t i = 0; i < length; ++i) {
+        bytes[i] = static_cast<char>('a' + (seed + i) % 26);
+    }
+    return bytes;
+}
+
+static void test_prune_farthest(const ReassemblerBackend backend) {
+    auto pool = make_shared<ReassemblyMemoryPool>(1000);
+    StreamReassembler first(4000, backend);
+    StreamReassembler second(4000, backend);
+    first.attach_memory_pool(pool);
+    second.attach_memory_pool(pool);
+    test_should_be(pool->members(), 2u);
+    const string first_data = stream_bytes(1, 2000);
+    const string second_data = stream_bytes(2, 2000);
+
+    first.push_substring(string_view(first_data).substr(100, 600), 100, false);
+    test_should_be(pool->charged(), 600u);
+
+    // 超出上限200字节：first的乱序数据延伸到700，比second的650更远，从它的末尾丢弃
+    second.push_substring(string_view(second_data).substr(50, 600), 50, false);
+    test_should_be(pool->charged(), 1000u);
+    test_should_be(first.unassembled_bytes(), 400u);
+    test_should_be(second.unassembled_bytes(), 600u);
+    test_should_be(first.pruned_bytes(), 200u);
+    test_should_be(pool->stats().pruned_bytes, 200u);
+    test_should_be(pool->stats().peak_charged_bytes, 1000u);
+
+    // 填上空洞后重组的字节归还给池；重传被丢弃的部分后first完整
+    first.push_substring(string_view(first_data).substr(0, 100), 0, false);
+    test_should_be(first.stream_out().buffer_size(), 500u);
+    test_should_be(pool->charged(), 600u);
+    first.push_substring(string_view(first_data).substr(500, 200), 500, false);
+    test_should_be(first.stream_out().read(700), first_data.substr(0, 700));
+
+    second.push_substring(string_view(second_data).substr(0, 50), 0, false);
+    test_should_be(pool->charged(), 0u);
+    test_should_be(second.stream_out().read(650), second_data.substr(0, 650));
+}
+
+static void test_random_within_limit(const ReassemblerBackend backend) {
+    constexpr size_t LIMIT = 3000;
+    constexpr size_t LENGTH = 100'000;
+    auto pool = make_shared<ReassemblyMemoryPool>(LIMIT);
+    StreamReassembler reassemblers[2] = {StreamReassembler(8000, backend), StreamReassembler(8000, backend)};
+    string data[2] = {stream_bytes(3, LENGTH), stream_bytes(4, LENGTH)};
+    string received[2];
+    for (auto &reassembler : reassemblers) {
+        reassembler.attach_memory_pool(pool);
+    }
+
+    // 随机发送接收窗口内的片段(相当于发送方不断重传未被确认的数据)，直到两条流都收完
+    mt19937 rng(7);
+    while (!reassemblers[0].stream_out().eof() || !reassemblers[1].stream_out().eof()) {
+        const size_t i = rng() % 2;
+        StreamReassembler &reassembler = reassemblers[i];
+        const size_t next = received[i].size();
+        if (next == LENGTH) {
+            continue;
+        }
+        const size_t index = min(next + rng() % 6000, LENGTH - 1);
+        const size_t length = min<size_t>(1 + rng() % 1500, LENGTH - index);
+        reassembler.push_substring(string_view(data[i]).substr(index, length), index, index + length == LENGTH);
+        received[i] += reassembler.stream_out().read(reassembler.stream_out().buffer_size());
+        test_should_hold(pool->charged() <= LIMIT);
+        test_should_be(pool->charged(), reassemblers[0].unassembled_bytes() + reassemblers[1].unassembled_bytes());
+    }
+    test_should_be(received[0], data[0]);
+    test_should_be(received[1], data[1]);
+    test_should_be(pool->charged(), 0u);
+    test_should_hold(pool->stats().prune_events > 0);
+    test_should_hold(pool->stats().peak_charged_bytes <= LIMIT);
+}
+
+static void test_move(const ReassemblerBackend backend) {
+    auto pool = make_shared<ReassemblyMemoryPool>(1000);
+    StreamReassembler original(4000, backend);
+    original.attach_memory_pool(pool);
+    const string data = stream_bytes(5, 2000);
+    original.push_substring(string_view(data).substr(100, 300), 100, false);
+
+    StreamReassembler moved(move(original));
+    test_should_be(pool->members(), 1u);
+    test_should_be(pool->charged(), 300u);
+
+    // 超出上限时修剪的是移动后的对象
+    StreamReassembler other(4000, backend);
+    other.attach_memory_pool(pool);
+    other.push_substring(string_view(data).substr(10, 800), 10, false);
+    test_should_be(pool->charged(), 1000u);
+    test_should_be(moved.pruned_bytes() + other.pruned_bytes(), 100u);
+
+    // 移动赋值：被覆盖的other先退出池并归还其字节
+    other = move(moved);
+    test_should_be(pool->members(), 1u);
+    test_should_be(pool->charged(), other.unassembled_bytes());
+    other.push_substring(string_view(data).substr(0, 400), 0, false);
+    test_should_be(other.stream_out().read(400), data.substr(0, 400));
+    test_should_be(pool->charged(), 0u);
+}
+
+int main() {
+    try {
+        for (const auto backend : {ReassemblerBackend::IntervalMap, ReassemblerBackend::Bitmap}) {
+            test_prune_farthest(backend);
+            test_random_within_limit(backend);
+            test_move(backend);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+#include "congestion_controller.hh"
+#include "link_simulator.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+
+// 接收窗口自动调整：普通的输出流随读取速率增大容量；并发模式的输出流不能改变容量，
+// 接收方、重组器与输出流三者的容量必须始终一致，传输仍能完成
+
+static constexpr size_t TRANSFER_BYTES = 5'000'000;
+static constexpr size_t INITIAL_CAPACITY = 64 << 10;
+static constexpr size_t MAX_CAPACITY = 4 << 20;
+
+//! \returns 传输过程中接收方容量的最大值
+static size_t run_transfer(const bool concurrent) {
+    TCPSender sender(8 << 20, TCPConfig::TIMEOUT_DFLT, WrappingInt32{0});
+    TCPReceiver receiver(INITIAL_CAPACITY);
+    receiver.enable_autotuning(MAX_CAPACITY);
+    if (concurrent) {
+        receiver.stream_out().make_concurrent();
+    }
+    sender.set_peer_window_shift(receiver.window_shift());
+    receiver.set_window_scaling(true);
+    sender.set_congestion_controller(make_unique<NewRenoController>());
+    sender.enable_adaptive_rto();
+
+    LinkConfig forward;
+    forward.bandwidth_bps = 100'000'000;
+    forward.delay_ms = 20;
+    LinkSimulator simulator(sender, receiver, forward, forward);
+    simulator.start(TRANSFER_BYTES);
+    size_t peak_capacity = receiver.capacity();
+    while (!simulator.step()) {
+        test_should_be(receiver.capacity(), receiver.stream_out().capacity());
+        test_should_hold(receiver.window_size() <= receiver.stream_out().remaining_capacity());
+        peak_capacity = max(peak_capacity, receiver.capacity());
+    }
+    test_should_hold(simulator.report().completed);
+    test_should_be(receiver.stream_out().bytes_read(), TRANSFER_BYTES);
+    return peak_capacity;
+}
+
+int main() {
+    try {
+        test_should_hold(run_transfer(false) > INITIAL_CAPACITY);
+        test_should_be(run_transfer(true), INITIAL_CAPACITY);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
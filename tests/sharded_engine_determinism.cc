@@ -0,0 +1,89 @@
+#include "congestion_controller.hh"
+#include "sharded_engine.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// 分片引擎的结果与shard数无关：同一批有丢包的连接分别交给1个与4个shard处理，
+// 每条连接的TransferReport逐项相同
+
+static constexpr size_t CONNECTIONS = 40;
+
+static vector<ConnectionResult> run_engine(const size_t shards) {
+    EngineConfig config;
+    config.sender_capacity = 64'000;
+    config.receiver_capacity = 64'000;
+    config.configure = [](TCPSender &sender, TCPReceiver &, LinkSimulator &simulator) {
+        sender.set_congestion_controller(make_unique<NewRenoController>());
+        sender.enable_fast_retransmit();
+        sender.enable_adaptive_rto();
+        simulator.enable_sack();
+    };
+
+    LinkConfig forward;
+    forward.bandwidth_bps = 10'000'000;
+    forward.delay_ms = 10;
+    forward.loss_rate = 0.02;
+    forward.queue_bytes = 32'000;
+    LinkConfig reverse;
+    reverse.delay_ms = 10;
+    reverse.loss_rate = 0.01;
+
+    ShardedEngine engine(shards, config);
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        ConnectionRequest request;
+        request.tuple = {0x0a000001, 0x0a000002, static_cast<uint16_t>(30000 + i), 80};
+        request.transfer_bytes = 100'000 + 5'000 * i;
+        request.forward = forward;
+        request.reverse = reverse;
+        request.seed = i + 1;
+        engine.submit(request);
+    }
+    vector<ConnectionResult> results = engine.finish();
+    sort(results.begin(), results.end(), [](const ConnectionResult &a, const ConnectionResult &b) {
+        return a.tuple.local_port < b.tuple.local_port;
+    });
+    return results;
+}
+
+int main() {
+    try {
+        const vector<ConnectionResult> single = run_engine(1);
+        const vector<ConnectionResult> sharded = run_engine(4);
+        test_should_be(single.size(), CONNECTIONS);
+        test_should_be(sharded.size(), CONNECTIONS);
+
+        uint64_t drops = 0;
+        for (size_t i = 0; i < CONNECTIONS; ++i) {
+            const TransferReport &a = single[i].report;
+            const TransferReport &b = sharded[i].report;
+            test_should_hold(single[i].tuple == sharded[i].tuple);
+            test_should_hold(a.completed);
+            test_should_hold(b.completed);
+            test_should_be(a.completion_ms, b.completion_ms);
+            test_should_be(a.segments_sent, b.segments_sent);
+            test_should_be(a.retransmissions, b.retransmissions);
+            test_should_be(a.acks_sent, b.acks_sent);
+            test_should_be(a.forward_drops, b.forward_drops);
+            test_should_be(a.reverse_drops, b.reverse_drops);
+            test_should_be(a.latency_p50_ms, b.latency_p50_ms);
+            test_should_be(a.latency_p90_ms, b.latency_p90_ms);
+            test_should_be(a.latency_p99_ms, b.latency_p99_ms);
+            test_should_be(a.latency_max_ms, b.latency_max_ms);
+            drops += a.forward_drops + a.reverse_drops;
+        }
+        // 确认这批连接确实经历了丢包与重传
+        test_should_hold(drops > 0);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
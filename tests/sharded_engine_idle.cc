@@ -0,0 +1,74 @@
+#include "sharded_engine.hh"
+#include "test_should_be.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sys/resource.h>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+// 分片引擎空闲时的退避：没有连接的shard不应占用CPU，阻塞等待后仍能被新提交的连接及时唤醒
+
+//! \returns 本进程所有线程累计消耗的CPU时间(ms)
+static uint64_t cpu_time_ms() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto to_ms = [](const timeval &t) { return static_cast<uint64_t>(t.tv_sec) * 1000 + t.tv_usec / 1000; };
+    return to_ms(usage.ru_utime) + to_ms(usage.ru_stime);
+}
+
+static ConnectionRequest make_request(const size_t i) {
+    ConnectionRequest request;
+    request.tuple = {0x0a000001, 0x0a000002, static_cast<uint16_t>(20000 + i), 80};
+    request.transfer_bytes = 50'000;
+    request.forward.delay_ms = 5;
+    request.reverse.delay_ms = 5;
+    request.seed = i + 1;
+    return request;
+}
+
+int main() {
+    try {
+        constexpr size_t SHARDS = 4;
+        ShardedEngine engine(SHARDS);
+
+        // 各shard先经过自旋与让出CPU，随后阻塞：空闲的300ms内合计CPU时间应远小于四个忙等的线程
+        this_thread::sleep_for(milliseconds(100));
+        const uint64_t idle_start = cpu_time_ms();
+        this_thread::sleep_for(milliseconds(300));
+        const uint64_t idle_cpu_ms = cpu_time_ms() - idle_start;
+        test_should_hold(idle_cpu_ms < 60);
+
+        // 阻塞中的shard被提交唤醒，不必等到finish()
+        engine.submit(make_request(0));
+        vector<ConnectionResult> results;
+        const auto deadline = steady_clock::now() + seconds(10);
+        while (results.empty() && steady_clock::now() < deadline) {
+            results = engine.results();
+            this_thread::sleep_for(milliseconds(1));
+        }
+        test_should_be(results.size(), 1u);
+        test_should_hold(results.front().report.completed);
+
+        // 再次空闲后提交一批连接，全部完成并由四元组所属的shard处理
+        this_thread::sleep_for(milliseconds(100));
+        constexpr size_t CONNECTIONS = 16;
+        for (size_t i = 1; i <= CONNECTIONS; ++i) {
+            engine.submit(make_request(i));
+        }
+        results = engine.finish();
+        test_should_be(results.size(), CONNECTIONS);
+        for (const auto &result : results) {
+            test_should_hold(result.report.completed);
+            test_should_be(result.shard, engine.shard_of(result.tuple));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
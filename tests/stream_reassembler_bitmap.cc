@@ -0,0 +1,111 @@
+#include "stream_reassembler.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+// 位图加环形缓冲区后端的StreamReassembler：跨64位字边界的空洞、环绕环尾的乱序数据，
+// 以及改变容量时保留已存储的乱序字节；随机片段下与区间表后端的结果逐步一致
+
+static string stream_bytes(const size_t length) {
+    string bytes(length, '\0');
+    for (size_t i = 0; i < length; ++i) {
+        bytes[i] = static_cast<char>('a' + (i * 7) % 26);
+    }
+    return bytes;
+}
+
+static void test_word_boundaries() {
+    const string data = stream_bytes(256);
+    StreamReassembler reassembler(256, ReassemblerBackend::Bitmap);
+    // 空洞两端恰好落在字边界两侧
+    reassembler.push_substring(data.substr(63, 2), 63, false);
+    reassembler.push_substring(data.substr(127, 3), 127, false);
+    reassembler.push_substring(data.substr(192, 64), 192, true);
+    test_should_be(reassembler.unassembled_bytes(), 69u);
+    const auto ranges = reassembler.unassembled_ranges(10);
+    test_should_be(ranges.size(), 3u);
+    test_should_be(ranges[1].first, 127u);
+    test_should_be(ranges[1].second, 130u);
+
+    reassembler.push_substring(data.substr(0, 63), 0, false);
+    test_should_be(reassembler.stream_out().bytes_written(), 65u);
+    reassembler.push_substring(data.substr(65, 127), 65, false);
+    test_should_be(reassembler.unassembled_bytes(), 0u);
+    test_should_be(reassembler.stream_out().read(256), data);
+    test_should_hold(reassembler.stream_out().eof());
+}
+
+static void test_wraparound() {
+    // 容量100，环长度128：逐步读出使乱序数据多次跨过环尾
+    const string data = stream_bytes(10'000);
+    StreamReassembler reassembler(100, ReassemblerBackend::Bitmap);
+    string received;
+    for (size_t base = 0; base < data.size(); base += 90) {
+        const size_t length = min<size_t>(90, data.size() - base);
+        const size_t half = length / 2;
+        reassembler.push_substring(data.substr(base + half, length - half), base + half,
+                                   base + length == data.size());
+        reassembler.push_substring(data.substr(base, half), base, false);
+        received += reassembler.stream_out().read(100);
+    }
+    test_should_be(received, data);
+    test_should_hold(reassembler.stream_out().eof());
+}
+
+static void test_set_capacity_keeps_data() {
+    const string data = stream_bytes(5000);
+    StreamReassembler reassembler(200, ReassemblerBackend::Bitmap);
+    reassembler.push_substring(data.substr(150, 50), 150, false);
+    test_should_be(reassembler.set_capacity(4000), 4000u);
+    reassembler.push_substring(data.substr(1000, 3000), 1000, false);
+    // 缩小时不低于已存储数据延伸到的位置
+    test_should_be(reassembler.set_capacity(100), 4000u);
+    reassembler.push_substring(data.substr(0, 150), 0, false);
+    reassembler.push_substring(data.substr(200, 800), 200, false);
+    test_should_be(reassembler.stream_out().read(5000), data.substr(0, 4000));
+    test_should_be(reassembler.set_capacity(100), 100u);
+}
+
+static void test_matches_interval_map() {
+    constexpr size_t LENGTH = 50'000;
+    const string data = stream_bytes(LENGTH);
+    mt19937 rng(4);
+    StreamReassembler bitmap(3000, ReassemblerBackend::Bitmap);
+    StreamReassembler intervals(3000, ReassemblerBackend::IntervalMap);
+    while (!intervals.stream_out().eof()) {
+        const size_t next = intervals.stream_out().bytes_written();
+        const size_t index = min(next + rng() % 3500, LENGTH - 1);
+        const size_t length = min<size_t>(rng() % 700, LENGTH - index);
+        const bool eof = index + length == LENGTH;
+        bitmap.push_substring(data.substr(index, length), index, eof);
+        intervals.push_substring(data.substr(index, length), index, eof);
+        test_should_be(bitmap.stream_out().bytes_written(), intervals.stream_out().bytes_written());
+        test_should_be(bitmap.unassembled_bytes(), intervals.unassembled_bytes());
+        test_should_hold(bitmap.unassembled_ranges(8) == intervals.unassembled_ranges(8));
+        if (rng() % 2 == 0) {
+            const size_t length_read = rng() % 2000;
+            test_should_be(bitmap.stream_out().read(length_read), intervals.stream_out().read(length_read));
+        }
+    }
+    test_should_hold(bitmap.stream_out().eof());
+}
+
+int main() {
+    try {
+        test_word_boundaries();
+        test_wraparound();
+        test_set_capacity_keeps_data();
+        test_matches_interval_map();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include "stream_reassembler.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 区间表后端的StreamReassembler：重叠、重复与相邻的片段合并成互不相邻的区间，
+// unassembled_bytes()只计一次重复的字节，超出容量的字节被丢弃；随机片段下与逐字节的模型一致
+
+static void test_merging() {
+    StreamReassembler reassembler(100);
+    reassembler.push_substring("cde", 2, false);
+    reassembler.push_substring("ghi", 6, false);
+    test_should_be(reassembler.unassembled_bytes(), 6u);
+    test_should_be(reassembler.unassembled_ranges(10).size(), 2u);
+
+    // 填上两区间之间的空洞：三段合并为一个区间
+    reassembler.push_substring("def", 3, false);
+    reassembler.push_substring("fg", 5, false);
+    test_should_be(reassembler.unassembled_bytes(), 7u);
+    const auto ranges = reassembler.unassembled_ranges(10);
+    test_should_be(ranges.size(), 1u);
+    test_should_be(ranges.front().first, 2u);
+    test_should_be(ranges.front().second, 9u);
+
+    // 重复与被覆盖的片段不改变计数
+    reassembler.push_substring("cdefghi", 2, false);
+    reassembler.push_substring("e", 4, false);
+    test_should_be(reassembler.unassembled_bytes(), 7u);
+
+    reassembler.push_substring("ab", 0, false);
+    test_should_be(reassembler.unassembled_bytes(), 0u);
+    test_should_be(reassembler.stream_out().read(100), "abcdefghi");
+    test_should_hold(reassembler.empty());
+}
+
+static void test_capacity_and_eof() {
+    StreamReassembler reassembler(8);
+    reassembler.push_substring("abc", 0, false);
+    // 窗口为[3, 8)：超出的部分被丢弃，带eof的片段因此不能结束流
+    reassembler.push_substring("fghijk", 5, true);
+    test_should_be(reassembler.unassembled_bytes(), 3u);
+    reassembler.push_substring("de", 3, false);
+    test_should_be(reassembler.stream_out().read(100), "abcdefgh");
+    test_should_hold(!reassembler.stream_out().input_ended());
+    reassembler.push_substring("ijk", 8, true);
+    test_should_be(reassembler.stream_out().read(100), "ijk");
+    test_should_hold(reassembler.stream_out().eof());
+}
+
+static void test_random_against_model() {
+    constexpr size_t LENGTH = 20'000;
+    constexpr size_t CAPACITY = 1500;
+    mt19937 rng(3);
+    string data(LENGTH, '\0');
+    for (char &c : data) {
+        c = static_cast<char>('a' + rng() % 26);
+    }
+    StreamReassembler reassembler(CAPACITY);
+    vector<bool> held(LENGTH, false);
+    string received;
+    while (!reassembler.stream_out().eof()) {
+        const size_t next = reassembler.stream_out().bytes_written();
+        const size_t index = min(next + rng() % 2000, LENGTH - 1);
+        const size_t length = min<size_t>(rng() % 300, LENGTH - index);
+        reassembler.push_substring(data.substr(index, length), index, index + length == LENGTH);
+
+        // 模型：窗口[已写入, 已读出+容量)内的字节被保存
+        const size_t window_end = min(received.size() + CAPACITY, LENGTH);
+        for (size_t i = max(index, next); i < min(index + length, window_end); ++i) {
+            held[i] = true;
+        }
+        size_t assembled = next;
+        while (assembled < LENGTH && held[assembled]) {
+            ++assembled;
+        }
+        test_should_be(reassembler.stream_out().bytes_written(), assembled);
+        test_should_be(reassembler.unassembled_bytes(),
+                       static_cast<size_t>(count(held.begin() + assembled, held.end(), true)));
+
+        if (rng() % 3 == 0) {
+            received += reassembler.stream_out().read(rng() % 1000);
+        }
+    }
+    received += reassembler.stream_out().read(LENGTH);
+    test_should_be(received, data);
+}
+
+int main() {
+    try {
+        test_merging();
+        test_capacity_and_eof();
+        test_random_against_model();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
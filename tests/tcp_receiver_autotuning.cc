@@ -0,0 +1,144 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// 接收窗口自动调整的各个阶段：窗口缩放位数按容量上限选择；读出速率提高时容量增长；
+// 空闲后容量回落到初始容量；回落时已通告的窗口不回缩，发送方用满它的数据都被接收
+
+static constexpr size_t INITIAL_CAPACITY = 20'000;
+static constexpr size_t MAX_CAPACITY = 1'000'000;
+static constexpr size_t IDLE_MS = 100;
+static constexpr size_t RTT_MS = 10;
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static void receive_syn(TCPReceiver &receiver) {
+    TCPSegment seg;
+    seg.header().seqno = WrappingInt32{0};
+    seg.header().syn = true;
+    receiver.segment_received(seg);
+    receiver.ack_sent();
+}
+
+//! 从流index为next处开始按MSS切分送达length字节，每个segment之后调用after_each
+static void deliver(TCPReceiver &receiver,
+                    uint64_t &next,
+                    const size_t length,
+                    const function<void()> &after_each = {}) {
+    for (size_t sent = 0; sent < length;) {
+        const size_t size = min(MSS, length - sent);
+        TCPSegment seg;
+        seg.header().seqno = WrappingInt32{static_cast<uint32_t>(1 + next)};
+        seg.payload() = Buffer(string(size, 'x'));
+        receiver.segment_received(seg);
+        next += size;
+        sent += size;
+        if (after_each) {
+            after_each();
+        }
+    }
+}
+
+static void read_all(TCPReceiver &receiver) { receiver.stream_out().pop_output(receiver.stream_out().buffer_size()); }
+
+//! \returns 接收方当前窗口的右边界(绝对序号)
+static uint64_t right_edge(const TCPReceiver &receiver) {
+    return 1 + receiver.stream_out().bytes_written() + receiver.window_size();
+}
+
+//! 每个RTT送达一整个窗口并全部读出，随后通告新的窗口：读出速率不断提高，容量随之增长
+static void grow(TCPReceiver &receiver, uint64_t &next) {
+    for (size_t round = 0; round < 8; ++round) {
+        receiver.tick(RTT_MS);
+        deliver(receiver, next, receiver.window_size());
+        read_all(receiver);
+        receiver.ack_sent();
+    }
+    test_should_hold(receiver.capacity() > INITIAL_CAPACITY);
+    test_should_hold(receiver.capacity() <= MAX_CAPACITY);
+    test_should_be(receiver.stream_out().capacity(), receiver.capacity());
+}
+
+static void test_window_shift() {
+    TCPReceiver receiver(60'000);
+    test_should_be(receiver.window_shift(), 0);
+    // 窗口缩放位数按容量上限选择：4000000 >> 6 = 62500
+    receiver.enable_autotuning(4'000'000);
+    test_should_be(receiver.window_shift(), 6);
+    test_should_be(receiver.capacity(), 60'000u);
+    receiver.set_window_scaling(true);
+    receive_syn(receiver);
+    test_should_be(receiver.window_field(), 60'000 >> 6);
+
+    // 上限低于初始容量时按初始容量选择
+    TCPReceiver small(60'000);
+    small.enable_autotuning(1'000);
+    test_should_be(small.window_shift(), 0);
+}
+
+static void test_idle_fallback() {
+    TCPReceiver receiver(INITIAL_CAPACITY);
+    receiver.enable_autotuning(MAX_CAPACITY, IDLE_MS);
+    receive_syn(receiver);
+    uint64_t next = 0;
+    grow(receiver, next);
+
+    // 最后一个窗口送达并读出后不再通告新的窗口，之后连接空闲
+    receiver.tick(RTT_MS);
+    deliver(receiver, next, receiver.window_size());
+    read_all(receiver);
+    receiver.tick(1);
+    test_should_hold(receiver.capacity() > INITIAL_CAPACITY);
+    receiver.tick(IDLE_MS);
+    test_should_be(receiver.capacity(), INITIAL_CAPACITY);
+    test_should_be(receiver.stream_out().capacity(), INITIAL_CAPACITY);
+    test_should_be(receiver.window_size(), INITIAL_CAPACITY);
+}
+
+static void test_shrink_keeps_advertised_window() {
+    TCPReceiver receiver(INITIAL_CAPACITY);
+    receiver.enable_autotuning(MAX_CAPACITY, IDLE_MS);
+    receive_syn(receiver);
+    uint64_t next = 0;
+    grow(receiver, next);
+
+    // grow最后通告了一整个窗口，随后空闲：目标容量回落，已通告的窗口保留
+    const size_t grown = receiver.capacity();
+    const uint64_t advertised = right_edge(receiver);
+    receiver.tick(1);
+    receiver.tick(IDLE_MS);
+    test_should_be(receiver.capacity(), grown);
+    test_should_be(right_edge(receiver), advertised);
+
+    // 发送方用满已通告的窗口，应用边收边读：容量逐步缩小，右边界不回缩，每个segment都被接收
+    size_t previous = grown;
+    deliver(receiver, next, advertised - 1 - receiver.stream_out().bytes_written(), [&] {
+        test_should_be(receiver.unassembled_bytes(), 0u);
+        test_should_hold(right_edge(receiver) >= advertised);
+        test_should_hold(receiver.capacity() <= previous);
+        previous = receiver.capacity();
+        read_all(receiver);
+    });
+    test_should_be(receiver.stream_out().bytes_written() + 1, advertised);
+    test_should_be(receiver.capacity(), INITIAL_CAPACITY);
+    test_should_be(receiver.stream_out().capacity(), INITIAL_CAPACITY);
+}
+
+int main() {
+    try {
+        test_window_shift();
+        test_idle_fallback();
+        test_shrink_keeps_advertised_window();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "tcp_receiver.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// 批量接收：随机的批次中包含乱序、重复与相互重叠的segment，以及SYN之前到达的segment；
+// 容量足够时segments_received()与逐个调用segment_received()得到相同的ackno、窗口、乱序字节数与输出；
+// 重组器与字节流直接接受调用方持有的string_view切片
+
+static const WrappingInt32 ISN{0xffffc000};
+
+static TCPSegment make_segment(const string &data, const uint64_t begin, const uint64_t end) {
+    TCPSegment seg;
+    seg.header().seqno = ISN + static_cast<uint32_t>(1 + begin);
+    seg.header().fin = (end == data.size());
+    seg.payload() = Buffer(data.substr(begin, end - begin));
+    return seg;
+}
+
+// 乱序到达的切片只在等待前面的字节时被复制，切片指向的内存之后被改写不影响已缓存的数据
+static void test_string_view_slices() {
+    string data = "abcdefghijklmnop";
+    StreamReassembler reassembler(64);
+    reassembler.push_substring(string_view(data).substr(8, 8), 8, true);
+    reassembler.push_substring(string_view(data).substr(4, 4), 4, false);
+    test_should_be(reassembler.unassembled_bytes(), 12u);
+    data.replace(4, 12, 12, '#');
+    reassembler.push_substring(string_view(data).substr(0, 4), 0, false);
+    test_should_be(reassembler.unassembled_bytes(), 0u);
+    test_should_be(reassembler.stream_out().read(16), "abcdefghijklmnop");
+    test_should_hold(reassembler.stream_out().eof());
+
+    ByteStream stream(8);
+    test_should_be(stream.write(string_view("0123456789").substr(2, 6)), 6u);
+    test_should_be(stream.write(string_view("abcd")), 2u);
+    test_should_be(stream.read(8), "234567ab");
+}
+
+int main() {
+    try {
+        constexpr size_t TOTAL = 200000;
+        mt19937 rng(19);
+        string data(TOTAL, '\0');
+        for (char &c : data) {
+            c = static_cast<char>(rng());
+        }
+
+        TCPReceiver batched(TOTAL + 1);
+        TCPReceiver reference(TOTAL + 1);
+        string batched_out;
+        string reference_out;
+        uint64_t next = 0;  // 保证进展：每批都包含一个从这里开始的segment
+        bool syn_sent = false;
+
+        for (size_t round = 0; round < 100000 && !batched.stream_out().eof(); ++round) {
+            vector<TCPSegment> batch;
+            const size_t count = 1 + rng() % 64;
+            for (size_t i = 0; i < count; ++i) {
+                const uint64_t begin = (i == 0) ? next : rng() % TOTAL;
+                const uint64_t end = min<uint64_t>(TOTAL, begin + 1 + rng() % 3000);
+                batch.push_back(make_segment(data, begin, end));
+                if (i == 0) {
+                    next = end;
+                }
+            }
+            // SYN在第一批的中间到达，之前的segment被忽略
+            if (!syn_sent) {
+                TCPSegment syn;
+                syn.header().seqno = ISN;
+                syn.header().syn = true;
+                batch.insert(batch.begin() + batch.size() / 2, syn);
+                syn_sent = true;
+            }
+            // 重复一部分segment
+            for (size_t i = 0; i < count / 4; ++i) {
+                batch.push_back(batch[rng() % batch.size()]);
+            }
+
+            batched.segments_received(batch);
+            for (const TCPSegment &seg : batch) {
+                reference.segment_received(seg);
+            }
+            test_should_be(batched.ackno().value(), reference.ackno().value());
+            test_should_be(batched.window_size(), reference.window_size());
+            test_should_be(batched.unassembled_bytes(), reference.unassembled_bytes());
+            test_should_be(batched.stream_out().input_ended(), reference.stream_out().input_ended());
+            batched_out += batched.stream_out().read(TOTAL);
+            reference_out += reference.stream_out().read(TOTAL);
+            test_should_be(batched_out.size(), reference_out.size());
+            if (next == TOTAL) {
+                next = batched_out.size();
+            }
+        }
+        test_should_hold(batched.stream_out().eof());
+        test_should_hold(batched_out == data);
+        test_should_hold(reference_out == data);
+        test_should_be(batched.ackno().value(), ISN + static_cast<uint32_t>(TOTAL + 2));
+
+        test_string_view_slices();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
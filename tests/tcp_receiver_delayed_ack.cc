@@ -0,0 +1,102 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// 延迟ACK：SYN/FIN、乱序数据与填补空洞的数据立即确认；按序数据每两个满segment确认一次，
+// 否则在延迟时间后确认；应用读取数据后，窗口右边界扩大超过阈值时才需要发送窗口更新
+
+static const WrappingInt32 ISN{1000};
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! \param index 数据在流中的位置
+static TCPSegment segment(const uint64_t index, const size_t length, const bool fin = false) {
+    TCPSegment seg;
+    seg.header().seqno = ISN + static_cast<uint32_t>(1 + index);
+    seg.header().fin = fin;
+    seg.payload() = Buffer(string(length, 'x'));
+    return seg;
+}
+
+static void handshake(TCPReceiver &receiver) {
+    TCPSegment syn;
+    syn.header().seqno = ISN;
+    syn.header().syn = true;
+    receiver.segment_received(syn);
+    test_should_hold(receiver.ack_needed());
+    receiver.ack_sent();
+    test_should_hold(!receiver.ack_needed());
+}
+
+int main() {
+    try {
+        // 未启用时每个数据segment都立即确认
+        {
+            TCPReceiver receiver(10 * MSS);
+            test_should_hold(!receiver.ack_needed());
+            handshake(receiver);
+            receiver.segment_received(segment(0, 10));
+            test_should_hold(receiver.ack_needed());
+        }
+
+        TCPReceiver receiver(10 * MSS);
+        receiver.enable_delayed_ack(40);
+        handshake(receiver);
+
+        // 每两个满segment确认一次
+        receiver.segment_received(segment(0, MSS));
+        test_should_hold(!receiver.ack_needed());
+        receiver.segment_received(segment(MSS, MSS));
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+
+        // 不足两个segment时等待延迟ACK计时器
+        receiver.segment_received(segment(2 * MSS, 100));
+        receiver.tick(39);
+        test_should_hold(!receiver.ack_needed());
+        receiver.tick(1);
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+        receiver.tick(1000);
+        test_should_hold(!receiver.ack_needed());
+
+        // 乱序数据与填补空洞的数据立即确认
+        const uint64_t next = 2 * MSS + 100;
+        receiver.segment_received(segment(next + 100, 100));
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+        receiver.segment_received(segment(next, 100));
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+
+        // 重复的数据立即确认(对方可能没有收到之前的ACK)
+        receiver.segment_received(segment(0, 100));
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+
+        // 窗口更新：右边界扩大两个MSS时才需要通告
+        const size_t buffered = receiver.stream_out().buffer_size();
+        test_should_be(buffered, next + 200);
+        receiver.stream_out().pop_output(MSS);
+        test_should_hold(!receiver.ack_needed());
+        receiver.stream_out().pop_output(MSS);
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+
+        // FIN立即确认
+        receiver.segment_received(segment(next + 200, 0, true));
+        test_should_hold(receiver.ack_needed());
+        receiver.ack_sent();
+        test_should_hold(receiver.stream_out().input_ended());
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#include "congestion_controller.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// SACK：接收方按序号升序导出它持有的乱序区间，发送方据此把被覆盖的segment移出在途字节，
+// 只重传空洞，空洞补上后接收方的ackno一次推进到全部数据之后；有拥塞控制时，一次检测出的多个空洞
+// 除第一个外都受拥塞窗口约束；被SACK的segment不作为RTT样本
+
+static const WrappingInt32 ISN{0xfffff000};  // 让序号在传输过程中回绕
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        constexpr size_t SEGMENTS = 10;
+        TCPSender sender(64000, 1000, ISN);
+        TCPReceiver receiver(64000);
+        const auto ack = [&] {
+            sender.ack_received(receiver.ackno().value(), receiver.window_size(), receiver.sack_blocks());
+        };
+
+        // 握手后一次发出10个满MSS的segment，丢弃第2与第5个
+        sender.fill_window();
+        receiver.segment_received(sender.segments_out().front());
+        sender.segments_out().pop();
+        ack();
+        sender.stream_in().write(string(SEGMENTS * MSS, 'x'));
+        sender.fill_window();
+        test_should_be(sender.segments_out().size(), SEGMENTS);
+        const set<size_t> dropped{2, 5};
+        vector<WrappingInt32> seqnos;
+        for (size_t i = 0; !sender.segments_out().empty(); ++i) {
+            seqnos.push_back(sender.segments_out().front().header().seqno);
+            if (!dropped.count(i)) {
+                receiver.segment_received(sender.segments_out().front());
+            }
+            sender.segments_out().pop();
+        }
+
+        // 接收方导出[3, 5)与[6, 10)两个区间，max_blocks限制导出的块数
+        const vector<SackBlock> blocks = receiver.sack_blocks();
+        test_should_be(blocks.size(), 2u);
+        test_should_be(blocks[0].left, seqnos[3]);
+        test_should_be(blocks[0].right, seqnos[5]);
+        test_should_be(blocks[1].left, seqnos[6]);
+        test_should_be(blocks[1].right, seqnos[9] + MSS);
+        test_should_be(receiver.sack_blocks(1).size(), 1u);
+        test_should_be(receiver.ackno().value(), seqnos[2]);
+
+        // 发送方只把两个空洞计入在途字节，并且只重传这两个空洞
+        ack();
+        test_should_be(sender.bytes_in_flight(), 2 * MSS);
+        test_should_be(sender.segments_out().size(), 2u);
+        for (const size_t hole : dropped) {
+            test_should_be(sender.segments_out().front().header().seqno, seqnos[hole]);
+            receiver.segment_received(sender.segments_out().front());
+            sender.segments_out().pop();
+        }
+
+        // 重复的SACK不会再次重传
+        sender.ack_received(seqnos[2], receiver.window_size(), blocks);
+        test_should_hold(sender.segments_out().empty());
+
+        // 空洞补上后全部数据被累积确认
+        test_should_be(receiver.ackno().value(), seqnos[9] + MSS);
+        test_should_hold(receiver.sack_blocks().empty());
+        ack();
+        test_should_be(sender.bytes_in_flight(), 0u);
+        test_should_be(receiver.stream_out().buffer_size(), SEGMENTS * MSS);
+
+        // 有拥塞控制时丢弃第0、2、4、6个segment：第0个立即重传，其余按减半后的拥塞窗口(2个MSS)重传
+        {
+            TCPSender cc_sender(64000, 1000, ISN);
+            TCPReceiver cc_receiver(64000);
+            cc_sender.set_congestion_controller(make_unique<NewRenoController>(MSS, SEGMENTS));
+            cc_sender.fill_window();
+            cc_receiver.segment_received(cc_sender.segments_out().front());
+            cc_sender.segments_out().pop();
+            cc_sender.ack_received(cc_receiver.ackno().value(), cc_receiver.window_size());
+            cc_sender.stream_in().write(string(SEGMENTS * MSS, 'x'));
+            cc_sender.fill_window();
+            test_should_be(cc_sender.segments_out().size(), SEGMENTS);
+            vector<WrappingInt32> sent;
+            for (size_t i = 0; !cc_sender.segments_out().empty(); ++i) {
+                sent.push_back(cc_sender.segments_out().front().header().seqno);
+                if ((i > 6) || (i % 2 == 1)) {
+                    cc_receiver.segment_received(cc_sender.segments_out().front());
+                }
+                cc_sender.segments_out().pop();
+            }
+            cc_sender.ack_received(
+                cc_receiver.ackno().value(), cc_receiver.window_size(), cc_receiver.sack_blocks());
+            test_should_be(cc_sender.cwnd().value(), 2 * MSS);
+            test_should_be(cc_sender.segments_out().size(), 2u);
+            test_should_be(cc_sender.segments_out().front().header().seqno, sent[0]);
+            cc_sender.segments_out().pop();
+            test_should_be(cc_sender.segments_out().front().header().seqno, sent[2]);
+            cc_sender.segments_out().pop();
+            test_should_be(cc_sender.bytes_in_flight(), 4 * MSS);
+        }
+
+        // 被SACK的segment在空洞修复后才被累积确认，这段时间不作为RTT样本
+        {
+            TCPSender rtt_sender(64000, 1000, ISN);
+            rtt_sender.enable_adaptive_rto(10, 5000);
+            rtt_sender.fill_window();
+            rtt_sender.segments_out().pop();
+            rtt_sender.tick(40);
+            rtt_sender.ack_received(wrap(1, ISN), UINT16_MAX);
+            test_should_be(rtt_sender.srtt().value(), 40.0);
+            rtt_sender.stream_in().write(string(2 * MSS, 'x'));
+            rtt_sender.fill_window();
+            rtt_sender.segments_out() = {};
+
+            // 第1个segment丢失，第2个40ms后被SACK；RTO(120ms)到期后重传第1个，再过10ms一起被确认
+            rtt_sender.tick(40);
+            rtt_sender.ack_received(wrap(1, ISN), UINT16_MAX, {{wrap(1 + MSS, ISN), wrap(1 + 2 * MSS, ISN)}});
+            rtt_sender.tick(80);
+            test_should_be(rtt_sender.segments_out().size(), 1u);
+            rtt_sender.tick(10);
+            rtt_sender.ack_received(wrap(1 + 2 * MSS, ISN), UINT16_MAX);
+            test_should_be(rtt_sender.bytes_in_flight(), 0u);
+            test_should_be(rtt_sender.srtt().value(), 40.0);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+// 自适应RTO(RFC 6298)：由未重传segment的RTT样本计算SRTT与RTTVAR，RTO = SRTT + 4 * RTTVAR，
+// 重传过的segment不作为样本(Karn算法)，RTO及其指数退避都被限制在[min_rto, max_rto]内
+
+static const WrappingInt32 ISN{0};
+
+// 写入一段数据并在rtt_ms毫秒后确认它
+// \returns 发送时计时器采用的RTO
+static unsigned int send_and_ack(TCPSender &sender, const size_t rtt_ms) {
+    sender.stream_in().write(string(100, 'x'));
+    sender.fill_window();
+    test_should_be(sender.segments_out().size(), 1u);
+    sender.segments_out().pop();
+    const optional<unsigned int> rto = sender.rto();
+    test_should_hold(rto.has_value());
+    sender.tick(rtt_ms);
+    sender.ack_received(wrap(sender.next_seqno_absolute(), ISN), 1000);
+    test_should_be(sender.bytes_in_flight(), 0u);
+    return rto.value();
+}
+
+int main() {
+    try {
+        // 未启用时始终使用固定的初始RTO
+        {
+            TCPSender sender(4000, 1000, ISN);
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.tick(40);
+            sender.ack_received(wrap(1, ISN), 1000);
+            test_should_be(send_and_ack(sender, 40), 1000u);
+        }
+
+        // 首个样本：SRTT = R，RTTVAR = R / 2，之后按1/8与1/4的增益平滑
+        {
+            TCPSender sender(4000, 1000, ISN);
+            sender.enable_adaptive_rto(10, 5000);
+            sender.fill_window();
+            sender.segments_out().pop();
+            test_should_be(sender.rto().value(), 1000u);
+            sender.tick(40);
+            sender.ack_received(wrap(1, ISN), 1000);
+            test_should_be(sender.srtt().value(), 40.0);
+            test_should_be(send_and_ack(sender, 80), 120u);  // RTTVAR = 20
+            // RTTVAR = 0.75 * 20 + 0.25 * 40 = 25，SRTT = 0.875 * 40 + 0.125 * 80 = 45
+            test_should_be(sender.srtt().value(), 45.0);
+
+            // Karn算法：超时重传后的确认不更新SRTT
+            sender.stream_in().write(string(100, 'x'));
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.tick(145);
+            test_should_be(sender.segments_out().size(), 1u);
+            sender.segments_out().pop();
+            sender.tick(200);
+            sender.ack_received(wrap(sender.next_seqno_absolute(), ISN), 1000);
+            test_should_be(sender.srtt().value(), 45.0);
+            test_should_be(send_and_ack(sender, 45), 145u);
+        }
+
+        // RTO的上下界
+        {
+            TCPSender sender(4000, 1000, ISN);
+            sender.enable_adaptive_rto(200, 600);
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.tick(5);
+            sender.ack_received(wrap(1, ISN), 1000);
+            test_should_be(send_and_ack(sender, 5), 200u);
+
+            // 指数退避不超过上界
+            sender.stream_in().write(string(100, 'x'));
+            sender.fill_window();
+            sender.segments_out().pop();
+            unsigned int expected = 200;
+            for (unsigned int retransmissions = 1; retransmissions <= 4; ++retransmissions) {
+                sender.tick(expected);
+                test_should_be(sender.segments_out().size(), 1u);
+                sender.segments_out().pop();
+                test_should_be(sender.consecutive_retransmissions(), retransmissions);
+                expected = min(2 * expected, 600u);
+                test_should_be(sender.rto().value(), expected);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
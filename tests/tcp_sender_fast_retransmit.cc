@@ -0,0 +1,117 @@
+#include "congestion_controller.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// 快速重传与NewReno快速恢复：第三个重复ACK立即重传第一个未确认的segment，之后的重复ACK膨胀拥塞窗口、
+// 继续发送新数据，部分确认立即重传下一个空洞且不增长拥塞窗口，一个窗口内的两处丢包不需要等待任何一次超时
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static WrappingInt32 seqno_of(const uint64_t segment_index) {
+    return WrappingInt32{static_cast<uint32_t>(1 + segment_index * MSS)};
+}
+
+//! \returns 取出的segment数，first为其中第一个segment的序号
+static size_t drain(TCPSender &sender, WrappingInt32 *first = nullptr) {
+    size_t count = 0;
+    while (!sender.segments_out().empty()) {
+        if (first != nullptr && count == 0) {
+            *first = sender.segments_out().front().header().seqno;
+        }
+        sender.segments_out().pop();
+        ++count;
+    }
+    return count;
+}
+
+// 握手后发出10个满MSS的segment，拥塞窗口为10个MSS(加上确认SYN的1字节)
+static void send_window(TCPSender &sender, const bool fast_retransmit) {
+    sender.set_congestion_controller(make_unique<NewRenoController>(MSS, 10));
+    sender.enable_fast_retransmit(fast_retransmit);
+    sender.fill_window();
+    drain(sender);
+    sender.ack_received(seqno_of(0), UINT16_MAX);
+    sender.stream_in().write(string(10 * MSS, 'x'));
+    sender.fill_window();
+    test_should_be(drain(sender), 10u);
+}
+
+int main() {
+    try {
+        // 未启用时重复ACK被忽略
+        {
+            TCPSender sender(1 << 20, 1000, WrappingInt32{0});
+            send_window(sender, false);
+            for (size_t i = 0; i < 5; ++i) {
+                sender.ack_received(seqno_of(0), UINT16_MAX);
+            }
+            test_should_be(drain(sender), 0u);
+        }
+
+        // 第0与第3个segment丢失，其余8个segment各引起一个重复ACK
+        {
+            TCPSender sender(1 << 20, 1000, WrappingInt32{0});
+            send_window(sender, true);
+            sender.ack_received(seqno_of(0), UINT16_MAX);
+            sender.ack_received(seqno_of(0), UINT16_MAX);
+            test_should_be(drain(sender), 0u);
+
+            // 第三个重复ACK：重传第0个segment，cwnd减半为5个MSS，膨胀3个MSS后仍小于在途的10个MSS
+            WrappingInt32 first{0};
+            sender.ack_received(seqno_of(0), UINT16_MAX);
+            test_should_be(drain(sender, &first), 1u);
+            test_should_be(first, seqno_of(0));
+            sender.stream_in().write(string(10 * MSS, 'x'));
+
+            // 之后每个重复ACK膨胀一个MSS，窗口超过在途字节数后每个重复ACK放出一个新segment
+            for (size_t i = 0; i < 5; ++i) {
+                sender.ack_received(seqno_of(0), UINT16_MAX);
+            }
+            test_should_be(drain(sender, &first), 3u);
+            test_should_be(first, seqno_of(10));
+
+            // 部分确认(恢复点之前)：第3个segment也已丢失，立即重传
+            sender.ack_received(seqno_of(3), UINT16_MAX);
+            test_should_hold(drain(sender, &first) >= 1);
+            test_should_be(first, seqno_of(3));
+
+            // 确认越过恢复点后退出快速恢复，窗口只用于发送新数据，整个过程没有发生超时
+            const uint64_t sent = sender.next_seqno_absolute();
+            sender.ack_received(wrap(sent, WrappingInt32{0}), UINT16_MAX);
+            test_should_hold(drain(sender, &first) >= 1);
+            test_should_be(first, wrap(sent, WrappingInt32{0}));
+            test_should_be(sender.bytes_in_flight(), sender.next_seqno_absolute() - sent);
+            test_should_be(sender.consecutive_retransmissions(), 0u);
+        }
+
+        // 第0与第7个segment丢失：部分确认了超过一个拥塞窗口的数据，但恢复期间拥塞窗口不增长
+        {
+            TCPSender sender(1 << 20, 1000, WrappingInt32{0});
+            send_window(sender, true);
+            for (size_t i = 0; i < 3; ++i) {
+                sender.ack_received(seqno_of(0), UINT16_MAX);
+            }
+            test_should_be(drain(sender), 1u);
+            const uint64_t cwnd = sender.cwnd().value();
+            test_should_be(cwnd, 5 * MSS);
+
+            WrappingInt32 first{0};
+            sender.ack_received(seqno_of(7), UINT16_MAX);
+            test_should_be(drain(sender, &first), 1u);
+            test_should_be(first, seqno_of(7));
+            test_should_be(sender.cwnd().value(), cwnd);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
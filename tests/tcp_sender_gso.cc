@@ -0,0 +1,128 @@
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// GSO大segment与批量取出：split_segment()按MSS切分且不复制负载，SYN只在第一段、FIN只在最后一段；
+// 开启GSO的发送方经过切分、随机丢包与部分确认后，接收方仍然得到完整的数据
+
+static const WrappingInt32 ISN{0xffffff00};
+
+static void test_split() {
+    TCPSegment big;
+    big.header().seqno = ISN;
+    big.header().syn = true;
+    big.header().fin = true;
+    big.payload() = Buffer(string(2500, 'x'));
+
+    const vector<SegmentPiece> pieces = TCPSender::split_segment(big, 1000);
+    test_should_be(pieces.size(), 3u);
+    const string_view whole = big.payload().str();
+    WrappingInt32 seqno = ISN;
+    size_t offset = 0;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        const SegmentPiece &piece = pieces[i];
+        test_should_be(piece.header().seqno, seqno);
+        test_should_be(piece.header().syn, i == 0);
+        test_should_be(piece.header().fin, i + 1 == pieces.size());
+        test_should_be(piece.payload().size(), i + 1 == pieces.size() ? 500u : 1000u);
+        // 负载指向大segment的存储
+        test_should_hold(piece.payload().data() == whole.data() + offset);
+        test_should_be(piece.segment().payload().str(), whole.substr(offset, piece.payload().size()));
+        seqno = seqno + static_cast<uint32_t>(piece.length_in_sequence_space());
+        offset += piece.payload().size();
+    }
+    test_should_be(seqno, ISN + static_cast<uint32_t>(big.length_in_sequence_space()));
+
+    // 不超过MSS的segment不切分
+    test_should_be(TCPSender::split_segment(big, 4000).size(), 1u);
+}
+
+static void test_batch() {
+    TCPSender sender(64000, 1000, ISN);
+    sender.fill_window();
+    sender.ack_received(ISN + 1, 10 * TCPConfig::MAX_PAYLOAD_SIZE);
+    sender.stream_in().write(string(5 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+    sender.fill_window();
+    test_should_be(sender.segments_out().size(), 6u);
+
+    vector<TCPSegment> batch;
+    test_should_be(sender.segments_out_batch(batch, 4), 4u);
+    test_should_be(batch.size(), 4u);
+    test_should_be(batch[0].header().seqno, ISN);
+    test_should_be(sender.segments_out_batch(batch, 4), 2u);
+    test_should_be(batch.size(), 6u);
+    test_should_be(sender.segments_out_batch(batch, 4), 0u);
+}
+
+// 开启GSO传输300KB，每个线上segment有1/drop的概率丢失
+static void test_transfer(const size_t drop) {
+    constexpr size_t GSO = 16;
+    mt19937 rng(13);
+    TCPSender sender(64000, 1000, ISN);
+    sender.enable_gso(GSO);
+    sender.enable_fast_retransmit();
+    TCPReceiver receiver(64000);
+
+    string data(300000, '\0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    size_t written = 0;
+    size_t produced = 0;
+    size_t wire = 0;
+    string received;
+    for (size_t round = 0; round < 100000 && !receiver.stream_out().input_ended(); ++round) {
+        if (written < data.size()) {
+            written += sender.stream_in().write(data.substr(written, 10000));
+            if (written == data.size()) {
+                sender.stream_in().end_input();
+            }
+        }
+        sender.fill_window();
+        vector<TCPSegment> batch;
+        while (sender.segments_out_batch(batch, 32) > 0) {
+            for (const TCPSegment &big : batch) {
+                ++produced;
+                test_should_hold(big.payload().size() <= GSO * TCPConfig::MAX_PAYLOAD_SIZE);
+                for (const SegmentPiece &piece : TCPSender::split_segment(big)) {
+                    ++wire;
+                    test_should_hold(piece.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE);
+                    if (drop > 0 && rng() % drop == 0) {
+                        continue;
+                    }
+                    receiver.segment_received(piece.segment());
+                    received += receiver.stream_out().read(receiver.stream_out().buffer_size());
+                    sender.ack_received(receiver.ackno().value(), receiver.window_field(), receiver.sack_blocks());
+                }
+            }
+            batch.clear();
+        }
+        sender.tick(10);
+    }
+    test_should_hold(receiver.stream_out().input_ended());
+    test_should_hold(received == data);
+    // 每个大segment平均覆盖多个线上segment
+    test_should_hold(produced * 2 < wire);
+}
+
+int main() {
+    try {
+        test_split();
+        test_batch();
+        test_transfer(0);
+        test_transfer(30);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// 发送方的在途字节计数与未确认队列：随机的写入、ACK(包括落在segment中间、过旧与超前的ACK)与超时下，
+// bytes_in_flight()始终等于未被完整确认的segment占用的序号数，超时重传的总是最早的未确认segment
+
+static const WrappingInt32 ISN{12345};
+
+int main() {
+    try {
+        constexpr uint16_t RTO = 100;
+        TCPSender sender(1 << 16, RTO, ISN);
+        mt19937 rng(5);
+        deque<pair<uint64_t, uint64_t>> outstanding;  // 模型：未被完整确认的segment的[起点, 终点)
+        uint64_t acked = 0;
+
+        // 取出segment：新发送的记入模型，重传的必须是最早的未确认segment
+        const auto drain = [&](const bool retransmission) {
+            while (!sender.segments_out().empty()) {
+                const TCPSegment &segment = sender.segments_out().front();
+                const uint64_t start = unwrap(segment.header().seqno, ISN, acked);
+                if (retransmission) {
+                    test_should_be(start, outstanding.front().first);
+                } else {
+                    outstanding.emplace_back(start, start + segment.length_in_sequence_space());
+                }
+                sender.segments_out().pop();
+            }
+        };
+
+        sender.fill_window();
+        drain(false);
+        for (size_t round = 0; round < 5000; ++round) {
+            if (rng() % 3 == 0 && !sender.stream_in().input_ended()) {
+                sender.stream_in().write(string(rng() % 3000, 'x'));
+                if (round > 4900) {
+                    sender.stream_in().end_input();
+                }
+                sender.fill_window();
+                drain(false);
+            }
+
+            const uint64_t next = sender.next_seqno_absolute();
+            switch (rng() % 4) {
+                case 0:  // 确认到任意位置，可能落在segment中间
+                    acked += rng() % (next - acked + 1);
+                    sender.ack_received(wrap(acked, ISN), 8000);
+                    while (!outstanding.empty() && outstanding.front().second <= acked) {
+                        outstanding.pop_front();
+                    }
+                    drain(false);
+                    break;
+                case 1:  // 过旧的ACK被忽略
+                    sender.ack_received(wrap(acked / 2, ISN), 8000);
+                    drain(false);
+                    break;
+                case 2:  // 确认尚未发送的数据，被忽略
+                    sender.ack_received(wrap(next + 1, ISN), 8000);
+                    drain(false);
+                    break;
+                default:  // 超时
+                    sender.tick(RTO << sender.consecutive_retransmissions());
+                    test_should_be(sender.segments_out().size(), outstanding.empty() ? 0u : 1u);
+                    drain(true);
+                    break;
+            }
+            uint64_t in_flight = 0;
+            for (const auto &segment : outstanding) {
+                in_flight += segment.second - segment.first;
+            }
+            test_should_be(sender.bytes_in_flight(), in_flight);
+        }
+
+        // 全部确认后队列清空，计时器停止
+        sender.ack_received(wrap(sender.next_seqno_absolute(), ISN), 8000);
+        test_should_be(sender.bytes_in_flight(), 0u);
+        sender.tick(1000 * RTO);
+        test_should_hold(sender.segments_out().empty());
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
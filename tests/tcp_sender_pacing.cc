@@ -0,0 +1,82 @@
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// pacing的令牌桶：无论tick间隔多长，受pacing限制的发送方都应维持配置的发送速率；
+// 空闲之后最多只能一次发出burst个字节
+
+static constexpr uint64_t RATE_BPS = 8'000'000;  // 每ms 1000字节
+static constexpr size_t BURST = 4 * TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! 发出并立即确认全部segment，返回其中的负载字节数
+static size_t send_and_ack(TCPSender &sender) {
+    size_t payload = 0;
+    while (!sender.segments_out().empty()) {
+        payload += sender.segments_out().front().payload().size();
+        sender.segments_out().pop();
+    }
+    sender.ack_received(sender.next_seqno(), UINT16_MAX);
+    return payload;
+}
+
+static void write_bytes(TCPSender &sender, const size_t bytes) {
+    sender.stream_in().write(string(bytes, 'x'));
+}
+
+static void test_rate_with_tick(const size_t tick_ms) {
+    TCPSender sender(4 << 20, TCPConfig::TIMEOUT_DFLT, WrappingInt32{0});
+    sender.enable_pacing(RATE_BPS, BURST);
+    sender.set_peer_window_shift(4);  // 接收窗口(1MB)不成为限制
+    sender.fill_window();
+    send_and_ack(sender);  // SYN
+    write_bytes(sender, 4 << 20);
+    sender.fill_window();
+    size_t sent = send_and_ack(sender);
+
+    constexpr size_t DURATION_MS = 1000;
+    for (size_t elapsed = 0; elapsed < DURATION_MS; elapsed += tick_ms) {
+        sender.tick(tick_ms);
+        sent += send_and_ack(sender);
+    }
+    const size_t expected = RATE_BPS / 8000 * DURATION_MS;
+    test_should_hold(sent >= expected * 95 / 100);
+    test_should_hold(sent <= expected + BURST + TCPConfig::MAX_PAYLOAD_SIZE);
+}
+
+static void test_no_burst_after_idle() {
+    TCPSender sender(4 << 20, TCPConfig::TIMEOUT_DFLT, WrappingInt32{0});
+    sender.enable_pacing(RATE_BPS, BURST);
+    sender.fill_window();
+    send_and_ack(sender);
+    write_bytes(sender, 10'000);
+    for (size_t i = 0; i < 100; ++i) {
+        sender.tick(1);
+        send_and_ack(sender);
+    }
+    test_should_be(sender.stream_in().buffer_size(), 0u);
+
+    // 空闲1s后写入大量数据：只有burst(加上最后一个使令牌变为负数的segment)能立即发出
+    sender.tick(1000);
+    write_bytes(sender, 1 << 20);
+    sender.fill_window();
+    test_should_hold(send_and_ack(sender) <= BURST + TCPConfig::MAX_PAYLOAD_SIZE);
+}
+
+int main() {
+    try {
+        for (const size_t tick_ms : {1, 10, 50, 200}) {
+            test_rate_with_tick(tick_ms);
+        }
+        test_no_burst_after_idle();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
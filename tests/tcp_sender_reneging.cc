@@ -0,0 +1,94 @@
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// 没有拥塞控制时的超时与SACK reneging：超时只重传最早的segment；被接收方丢弃的SACK数据
+// 每次只重传最早的一个，不会一次重发整个窗口；全部数据都被SACK后的超时重传队首。
+// bytes_in_flight()始终计入所有未被确认且未被SACK的数据
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr uint16_t RTO = 1000;
+
+//! \returns 取出的segment数，first为其中第一个segment的相对序号
+static size_t drain(TCPSender &sender, uint64_t *first = nullptr) {
+    size_t count = 0;
+    while (!sender.segments_out().empty()) {
+        if (first != nullptr && count == 0) {
+            *first = sender.segments_out().front().header().seqno.raw_value();
+        }
+        sender.segments_out().pop();
+        ++count;
+    }
+    return count;
+}
+
+int main() {
+    try {
+        TCPSender sender(1 << 20, RTO, WrappingInt32{0});
+        sender.fill_window();
+        drain(sender);
+        sender.ack_received(WrappingInt32{1}, UINT16_MAX);
+        sender.stream_in().write(string(10 * MSS, 'x'));
+        sender.fill_window();
+        test_should_be(drain(sender), 10u);
+        test_should_be(sender.bytes_in_flight(), 10 * MSS);
+
+        // 接收方持有第3、4个segment
+        const WrappingInt32 third{static_cast<uint32_t>(1 + 2 * MSS)};
+        const WrappingInt32 fifth{static_cast<uint32_t>(1 + 4 * MSS)};
+        sender.ack_received(WrappingInt32{1}, UINT16_MAX, {{third, fifth}});
+        test_should_be(sender.bytes_in_flight(), 8 * MSS);
+
+        // 超时只重传第一个segment
+        sender.tick(RTO);
+        uint64_t seqno = 0;
+        test_should_be(drain(sender, &seqno), 1u);
+        test_should_be(seqno, 1u);
+        test_should_be(sender.bytes_in_flight(), 8 * MSS);
+
+        // 前两个segment被确认，但ACK没有越过已被SACK的第3、4个segment：接收方丢弃了它们。
+        // ack_received与之后的每次fill_window各重传一个
+        sender.ack_received(third, UINT16_MAX);
+        test_should_be(sender.bytes_in_flight(), 8 * MSS);
+        test_should_be(drain(sender, &seqno), 1u);
+        test_should_be(seqno, third.raw_value());
+        sender.fill_window();
+        test_should_be(drain(sender, &seqno), 1u);
+        test_should_be(seqno, third.raw_value() + MSS);
+        sender.fill_window();
+        test_should_be(drain(sender), 0u);
+        test_should_be(sender.bytes_in_flight(), 8 * MSS);
+
+        sender.ack_received(WrappingInt32{static_cast<uint32_t>(1 + 10 * MSS)}, UINT16_MAX);
+        test_should_be(sender.bytes_in_flight(), 0u);
+
+        // 全部outstanding segment都被SACK后超时：不再信任SACK，重传队首
+        {
+            TCPSender sacked_sender(1 << 20, RTO, WrappingInt32{0});
+            sacked_sender.fill_window();
+            drain(sacked_sender);
+            sacked_sender.ack_received(WrappingInt32{1}, UINT16_MAX);
+            sacked_sender.stream_in().write(string(3 * MSS, 'x'));
+            sacked_sender.fill_window();
+            test_should_be(drain(sacked_sender), 3u);
+            const WrappingInt32 end{static_cast<uint32_t>(1 + 3 * MSS)};
+            sacked_sender.ack_received(WrappingInt32{1}, UINT16_MAX, {{WrappingInt32{1}, end}});
+            test_should_be(sacked_sender.bytes_in_flight(), 0u);
+            sacked_sender.tick(RTO);
+            test_should_be(drain(sacked_sender, &seqno), 1u);
+            test_should_be(seqno, 1u);
+            test_should_be(sacked_sender.bytes_in_flight(), MSS);
+            test_should_be(sacked_sender.consecutive_retransmissions(), 1u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "ring_deque.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace std;
+
+// 共享负载：RingDeque与std::deque的行为一致，弹出的元素立即释放持有的资源，稳定后不再增长；
+// 发送方发出与重传的segment共享同一份负载存储，没有数据可读时不产生segment
+
+static void test_ring_deque() {
+    RingDeque<shared_ptr<uint64_t>> ring;
+    deque<uint64_t> model;
+    mt19937 rng(21);
+    uint64_t next = 0;
+    for (size_t round = 0; round < 100000; ++round) {
+        // 队列长度在0到300之间随机游走，多次跨过环的边界并扩容
+        if (model.empty() || (rng() % 2 == 0 && model.size() < 300)) {
+            ring.push_back(make_shared<uint64_t>(next));
+            model.push_back(next++);
+        } else {
+            const weak_ptr<uint64_t> popped = ring.front();
+            ring.pop_front();
+            model.pop_front();
+            test_should_hold(popped.expired());
+        }
+        test_should_be(ring.size(), model.size());
+        if (!model.empty()) {
+            test_should_be(*ring.front(), model.front());
+            test_should_be(*ring.back(), model.back());
+            test_should_be(*ring[model.size() / 2], model[model.size() / 2]);
+        }
+        if (round % 1000 == 0 && !model.empty()) {
+            // 随机访问迭代器可用于二分查找
+            const uint64_t target = model[rng() % model.size()];
+            const auto it = lower_bound(ring.begin(), ring.end(), target,
+                                        [](const shared_ptr<uint64_t> &v, const uint64_t t) { return *v < t; });
+            test_should_be(static_cast<size_t>(it - ring.begin()), static_cast<size_t>(target - model.front()));
+        }
+    }
+    test_should_hold(ring.capacity() >= 300);
+    test_should_hold(ring.capacity() <= 512);
+    ring.clear();
+    test_should_hold(ring.empty());
+}
+
+static void test_sender_shares_payloads() {
+    TCPSender sender(64000, 1000, WrappingInt32{0});
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(WrappingInt32{1}, 1000);
+
+    // 没有数据可读时不产生segment
+    test_should_hold(sender.segments_out().empty());
+    test_should_be(sender.stream_in().read_buffer(100).size(), 0u);
+
+    sender.stream_in().write(string(500, 'x'));
+    sender.fill_window();
+    test_should_be(sender.segments_out().size(), 1u);
+    const TCPSegment sent = sender.segments_out().front();
+    sender.segments_out().pop();
+
+    // 重传的segment与第一次发出的segment指向同一份负载
+    sender.tick(1000);
+    test_should_be(sender.segments_out().size(), 1u);
+    const TCPSegment &retransmitted = sender.segments_out().front();
+    test_should_be(retransmitted.payload().size(), 500u);
+    test_should_hold(retransmitted.payload().str().data() == sent.payload().str().data());
+}
+
+int main() {
+    try {
+        test_ring_deque();
+        test_sender_shares_payloads();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
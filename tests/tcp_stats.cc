@@ -0,0 +1,184 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "tcp_stats.hh"
+#include "test_should_be.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// 连接统计：按一段固定的收发过程逐项核对发送方与接收方共享的计数器；
+// 另一个线程在连接运行期间读取快照，每个计数器都只增不减
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static void test_counters() {
+    auto stats = make_shared<TCPStats>();
+    TCPSender sender(64000, 1000, WrappingInt32{0});
+    TCPReceiver receiver(64000);
+    sender.set_stats(stats);
+    receiver.set_stats(stats);
+    sender.enable_fast_retransmit();
+
+    sender.fill_window();
+    receiver.segment_received(sender.segments_out().front());
+    sender.segments_out().pop();
+
+    // 窗口只容得下5个segment中的3个
+    sender.stream_in().write(string(5 * MSS, 'x'));
+    sender.ack_received(WrappingInt32{1}, 3 * MSS);
+    vector<TCPSegment> segments;
+    while (!sender.segments_out().empty()) {
+        segments.push_back(sender.segments_out().front());
+        sender.segments_out().pop();
+    }
+    test_should_be(segments.size(), 3u);
+    sender.tick(10);
+
+    // 第2个segment先到达
+    receiver.segment_received(segments[2]);
+    TCPStatsSnapshot snapshot = stats->snapshot();
+    test_should_be(snapshot.segments_sent, 4u);
+    test_should_be(snapshot.bytes_sent, 3 * MSS);
+    test_should_be(snapshot.segments_received, 2u);
+    test_should_be(snapshot.bytes_received, MSS);
+    test_should_be(snapshot.peak_unassembled_bytes, MSS);
+    test_should_be(snapshot.window_limited_ms, 10u);
+
+    // 三个重复ACK引起一次快速重传，之后超时引起一次超时重传
+    for (size_t i = 0; i < 3; ++i) {
+        sender.ack_received(WrappingInt32{1}, 3 * MSS);
+    }
+    sender.tick(1000);
+    snapshot = stats->snapshot();
+    test_should_be(snapshot.duplicate_acks, 3u);
+    test_should_be(snapshot.fast_retransmissions, 1u);
+    test_should_be(snapshot.rto_retransmissions, 1u);
+    test_should_be(snapshot.lost_retransmissions, 0u);
+    test_should_be(snapshot.segments_sent, 6u);
+    test_should_be(snapshot.bytes_sent, 5 * MSS);
+    test_should_be(snapshot.window_limited_ms, 1010u);
+
+    // 空洞补上后乱序字节归零，峰值保持不变
+    receiver.segment_received(segments[0]);
+    receiver.segment_received(segments[1]);
+    test_should_be(receiver.unassembled_bytes(), 0u);
+    snapshot = stats->snapshot();
+    test_should_be(snapshot.segments_received, 4u);
+    test_should_be(snapshot.bytes_received, 3 * MSS);
+    test_should_be(snapshot.peak_unassembled_bytes, MSS);
+
+    // 零窗口：发送方发出1字节的探测
+    sender.segments_out() = {};
+    sender.ack_received(WrappingInt32{static_cast<uint32_t>(1 + 3 * MSS)}, 0);
+    snapshot = stats->snapshot();
+    test_should_be(snapshot.zero_window_events, 1u);
+    test_should_be(snapshot.pacing_limited_ms, 0u);
+    test_should_be(snapshot.segments_sent, 7u);
+    test_should_be(snapshot.bytes_sent, 5 * MSS + 1);
+
+    // 全部确认后窗口有空余但没有数据可发
+    sender.ack_received(WrappingInt32{static_cast<uint32_t>(2 + 3 * MSS)}, 10 * MSS);
+    sender.ack_received(WrappingInt32{static_cast<uint32_t>(1 + 5 * MSS)}, 10 * MSS);
+    test_should_be(sender.bytes_in_flight(), 0u);
+    sender.tick(5);
+    snapshot = stats->snapshot();
+    test_should_be(snapshot.segments_sent, 9u);
+    test_should_be(snapshot.bytes_sent, 7 * MSS);
+    test_should_be(snapshot.app_limited_ms, 5u);
+    test_should_be(snapshot.window_limited_ms, 1010u);
+    test_should_be(snapshot.zero_window_events, 1u);
+    test_should_be(snapshot.ofo_pruned_bytes, 0u);
+    test_should_be(snapshot.pacing_limited_ms, 0u);
+}
+
+// 接收方丢弃了已SACK的segment(reneging)：发送方把它标记为丢失后重传，单独计数
+static void test_lost_retransmissions() {
+    auto stats = make_shared<TCPStats>();
+    TCPSender sender(64000, 1000, WrappingInt32{0});
+    sender.set_stats(stats);
+
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(WrappingInt32{1}, 10 * MSS);
+    sender.stream_in().write(string(3 * MSS, 'x'));
+    sender.fill_window();
+    sender.segments_out() = {};
+
+    const WrappingInt32 third{static_cast<uint32_t>(1 + 2 * MSS)};
+    const WrappingInt32 end{static_cast<uint32_t>(1 + 3 * MSS)};
+    sender.ack_received(WrappingInt32{1}, 10 * MSS, {{third, end}});
+    test_should_hold(sender.segments_out().empty());
+    sender.ack_received(third, 10 * MSS);
+    test_should_be(sender.segments_out().size(), 1u);
+    test_should_be(sender.segments_out().front().header().seqno, third);
+
+    const TCPStatsSnapshot snapshot = stats->snapshot();
+    test_should_be(snapshot.lost_retransmissions, 1u);
+    test_should_be(snapshot.rto_retransmissions, 0u);
+    test_should_be(snapshot.fast_retransmissions, 0u);
+    test_should_be(snapshot.segments_sent, 5u);
+}
+
+static void test_concurrent_snapshots() {
+    auto stats = make_shared<TCPStats>();
+    TCPSender sender(64000, 1000, WrappingInt32{0});
+    TCPReceiver receiver(64000);
+    sender.set_stats(stats);
+    receiver.set_stats(stats);
+
+    atomic<bool> done{false};
+    atomic<bool> decreased{false};
+    thread monitor([&] {
+        TCPStatsSnapshot last;
+        while (!done) {
+            const TCPStatsSnapshot snapshot = stats->snapshot();
+            if (snapshot.segments_sent < last.segments_sent || snapshot.bytes_sent < last.bytes_sent ||
+                snapshot.segments_received < last.segments_received ||
+                snapshot.bytes_received < last.bytes_received) {
+                decreased = true;
+            }
+            last = snapshot;
+        }
+    });
+
+    constexpr size_t ROUNDS = 20000;
+    sender.fill_window();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        while (!sender.segments_out().empty()) {
+            receiver.segment_received(sender.segments_out().front());
+            sender.segments_out().pop();
+        }
+        receiver.stream_out().pop_output(receiver.stream_out().buffer_size());
+        sender.stream_in().write(string(100, 'x'));
+        sender.ack_received(receiver.ackno().value(), receiver.window_field());
+    }
+    done = true;
+    monitor.join();
+
+    test_should_hold(!decreased);
+    const TCPStatsSnapshot snapshot = stats->snapshot();
+    test_should_be(snapshot.segments_sent, ROUNDS + 1);
+    test_should_be(snapshot.bytes_sent, ROUNDS * 100);
+    test_should_be(snapshot.segments_received, ROUNDS);
+}
+
+int main() {
+    try {
+        test_counters();
+        test_lost_retransmissions();
+        test_concurrent_snapshots();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// 窗口缩放(RFC 7323)：接收方按容量选择能在16位中通告整个窗口的最小位移，双方都提议时才生效，
+// 通告值向下取整；发送方按对方的位移还原窗口，一个RTT内就能发出远超64KB的数据
+
+static const WrappingInt32 ISN{0};
+
+static size_t drain_into(TCPSender &sender, TCPReceiver &receiver) {
+    size_t bytes = 0;
+    while (!sender.segments_out().empty()) {
+        bytes += sender.segments_out().front().payload().size();
+        receiver.segment_received(sender.segments_out().front());
+        sender.segments_out().pop();
+    }
+    return bytes;
+}
+
+int main() {
+    try {
+        constexpr size_t CAPACITY = 4 << 20;
+
+        // 小于64KB的容量不需要缩放
+        test_should_be(TCPReceiver(UINT16_MAX).window_shift(), 0u);
+        test_should_be(TCPReceiver(UINT16_MAX + 1).window_shift(), 1u);
+
+        TCPReceiver receiver(CAPACITY);
+        test_should_be(receiver.window_shift(), 7u);
+        TCPSender sender(CAPACITY, 1000, ISN);
+        sender.fill_window();
+        drain_into(sender, receiver);
+
+        // 未协商时通告值被截断为64KB
+        test_should_be(receiver.window_size(), CAPACITY);
+        test_should_be(receiver.window_field(), UINT16_MAX);
+
+        // 协商后：一个RTT内发出接近4MB的数据
+        receiver.set_window_scaling(true);
+        sender.set_peer_window_shift(receiver.window_shift());
+        test_should_be(receiver.window_field(), CAPACITY >> 7);
+        string data(CAPACITY, '\0');
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<char>(i * 7);
+        }
+        sender.stream_in().write(data);
+        sender.ack_received(receiver.ackno().value(), receiver.window_field());
+        test_should_be(drain_into(sender, receiver), CAPACITY);
+        test_should_be(receiver.window_size(), 0u);
+
+        // 窗口不是2^7的整数倍时向下取整，不会通告超过能容纳的数据
+        test_should_be(receiver.stream_out().read(1000), data.substr(0, 1000));
+        test_should_be(receiver.window_size(), 1000u);
+        test_should_be(receiver.window_field(), 1000u >> 7);
+        sender.stream_in().write(string(1000, 'y'));
+        sender.ack_received(receiver.ackno().value(), receiver.window_field());
+        test_should_be(drain_into(sender, receiver), (1000u >> 7) << 7);
+        test_should_be(receiver.stream_out().read(CAPACITY), data.substr(1000) + string((1000u >> 7) << 7, 'y'));
+
+        // 位移最多为14
+        TCPSender capped(1 << 20, 1000, ISN);
+        capped.set_peer_window_shift(20);
+        capped.fill_window();
+        capped.segments_out() = {};
+        capped.stream_in().write(string(1 << 20, 'z'));
+        capped.ack_received(WrappingInt32{1}, 1);
+        test_should_be(capped.bytes_in_flight(), 1u << 14);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,31 @@
+#ifndef SPONGE_TESTS_TEST_SHOULD_BE_HH
+#define SPONGE_TESTS_TEST_SHOULD_BE_HH
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// 各个测试共用的断言：不成立时抛出带有表达式与行号的runtime_error，由测试的main打印并返回EXIT_FAILURE
+
+#define test_should_be(act, exp) _test_should_be(act, exp, #act, #exp, __LINE__)
+#define test_should_hold(cond) _test_should_hold(cond, #cond, __LINE__)
+
+template <typename T, typename U>
+static void _test_should_be(const T &actual, const U &expected, const char *actual_s, const char *expected_s,
+                            const int lineno) {
+    if (actual != expected) {
+        std::ostringstream ss;
+        ss << "`" << actual_s << "` should have been `" << expected_s << "`, but the former is\n\t" << actual
+           << " and the latter is\n\t" << expected << "\n (at line " << lineno << ")\n";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+static inline void _test_should_hold(const bool condition, const char *condition_s, const int lineno) {
+    if (!condition) {
+        throw std::runtime_error("`" + std::string(condition_s) + "` should hold (at line " + std::to_string(lineno) +
+                                 ")");
+    }
+}
+
+#endif  // SPONGE_TESTS_TEST_SHOULD_BE_HH
@@ -0,0 +1,130 @@
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "timer_wheel.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 分层时间轮：随机设置、取消与前进时间，每个定时器都恰好在到期时刻触发一次，跨越各层的长超时经过下放后
+// 仍然准时，回调中可以设置与取消其他定时器；发送方挂在时间轮上后，超时重传只由时间轮驱动
+
+static void test_against_model() {
+    TimerWheel wheel;
+    mt19937 rng(10);
+    map<TimerWheel::TimerId, uint64_t> pending;  // 模型：未到期的定时器及其到期时间
+    size_t fired = 0;
+
+    // 到期时检查时刻，并有一定概率设置一个新定时器或取消另一个定时器
+    function<void(TimerWheel::TimerId)> on_fire;
+    const auto arm = [&](const uint64_t delay) {
+        const uint64_t deadline = wheel.now() + max<uint64_t>(delay, 1);
+        const auto id = make_shared<TimerWheel::TimerId>();
+        *id = wheel.arm(delay, [&, id, deadline] {
+            test_should_be(wheel.now(), deadline);
+            on_fire(*id);
+        });
+        pending[*id] = deadline;
+    };
+    const auto random_delay = [&] {
+        // 覆盖第0层到第2层
+        static const uint64_t ranges[] = {1 << 8, 1 << 12, 1 << 18};
+        return rng() % ranges[rng() % 3];
+    };
+    on_fire = [&](const TimerWheel::TimerId id) {
+        test_should_be(pending.erase(id), 1u);
+        ++fired;
+        if (rng() % 4 == 0) {
+            arm(rng() % 1000);
+        } else if (rng() % 4 == 0 && !pending.empty()) {
+            const TimerWheel::TimerId victim = pending.begin()->first;
+            test_should_hold(wheel.cancel(victim));
+            pending.erase(victim);
+        }
+    };
+
+    for (size_t round = 0; round < 20000; ++round) {
+        switch (rng() % 3) {
+            case 0:
+                arm(random_delay());
+                break;
+            case 1:
+                if (!pending.empty()) {
+                    auto it = pending.lower_bound(rng() % (pending.rbegin()->first + 1));
+                    test_should_hold(wheel.cancel(it->first));
+                    test_should_hold(!wheel.cancel(it->first));
+                    pending.erase(it);
+                }
+                break;
+            default:
+                wheel.advance(rng() % (1 << 12));
+                break;
+        }
+        test_should_be(wheel.size(), pending.size());
+    }
+
+    // 前进到所有定时器都到期，漏掉的定时器不会触发
+    for (size_t i = 0; i < 64 && !pending.empty(); ++i) {
+        wheel.advance(1 << 16);
+    }
+    test_should_hold(pending.empty());
+    test_should_be(wheel.size(), 0u);
+    test_should_hold(fired > 1000);
+
+    // 第3层：超过2^24ms的定时器经过三次下放后准时触发
+    bool long_fired = false;
+    const uint64_t deadline = wheel.now() + (1 << 24) + 12345;
+    wheel.arm(deadline - wheel.now(), [&] {
+        test_should_be(wheel.now(), deadline);
+        long_fired = true;
+    });
+    wheel.advance(deadline - wheel.now() - 1);
+    test_should_hold(!long_fired);
+    wheel.advance(1);
+    test_should_hold(long_fired);
+}
+
+static void test_sender_on_wheel() {
+    constexpr uint16_t RTO = 500;
+    auto wheel = make_shared<TimerWheel>();
+    TCPSender sender(4000, RTO, WrappingInt32{0});
+    sender.attach_timer_wheel(wheel);
+    sender.fill_window();
+    test_should_be(sender.segments_out().size(), 1u);
+    sender.segments_out().pop();
+    test_should_be(wheel->size(), 1u);
+
+    // 到期前不重传，到期时由时间轮触发重传并把RTO加倍
+    wheel->advance(RTO - 1);
+    test_should_hold(sender.segments_out().empty());
+    wheel->advance(1);
+    test_should_be(sender.segments_out().size(), 1u);
+    sender.segments_out().pop();
+    test_should_be(sender.consecutive_retransmissions(), 1u);
+    wheel->advance(2 * RTO - 1);
+    test_should_hold(sender.segments_out().empty());
+
+    // 全部确认后定时器被取消
+    sender.ack_received(WrappingInt32{1}, 1000);
+    test_should_be(wheel->size(), 0u);
+    wheel->advance(10 * RTO);
+    test_should_hold(sender.segments_out().empty());
+}
+
+int main() {
+    try {
+        test_against_model();
+        test_sender_on_wheel();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
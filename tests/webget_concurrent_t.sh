@@ -0,0 +1,94 @@
+#!/bin/bash
+
+# webget并发抓取模式的回环测试：启动本地替身服务器，对比抓取到的响应体与服务器生成的期望内容。
+# 用法：webget_concurrent_t.sh WEBGET HTTP_STANDIN_SERVER
+
+WEBGET=${1:?usage: $0 WEBGET HTTP_STANDIN_SERVER}
+SERVER=${2:?usage: $0 WEBGET HTTP_STANDIN_SERVER}
+
+WORK=$(mktemp -d)
+PIDS=()
+cleanup() {
+    for pid in "${PIDS[@]}"; do
+        kill "${pid}" 2>/dev/null
+    done
+    rm -rf "${WORK}"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL: $*" >&2
+    exit 1
+}
+
+# 启动一个替身服务器，等它打印出端口号
+start_server() {
+    local port_file="${WORK}/port.$#.$RANDOM"
+    "${SERVER}" "$@" > "${port_file}" &
+    PIDS+=($!)
+    for _ in $(seq 100); do
+        [ -s "${port_file}" ] && break
+        sleep 0.05
+    done
+    PORT=$(head -n 1 "${port_file}")
+    [ -n "${PORT}" ] || fail "server did not start"
+}
+
+PATHS=(/bytes/0 /bytes/1000 /chunked/300000 /early/5000 /bytes/8000000)
+REPEAT=3
+
+: > "${WORK}/expected"
+for _ in $(seq ${REPEAT}); do
+    for path in "${PATHS[@]}"; do
+        "${SERVER}" --body "${path}" >> "${WORK}/expected"
+    done
+done
+
+# fetch NAME WEBGET_OPTIONS...：用当前的${PORT}抓取全部路径REPEAT轮
+fetch() {
+    local name=$1
+    shift
+    local urls=()
+    for path in "${PATHS[@]}"; do
+        urls+=("127.0.0.1:${PORT}${path}")
+    done
+    timeout 60 "${WEBGET}" "$@" -n ${REPEAT} "${urls[@]}" > "${WORK}/${name}" 2> "${WORK}/${name}.err" \
+        || fail "${name}: webget exited with $? ($(cat "${WORK}/${name}.err"))"
+    grep -q "errors=0 " "${WORK}/${name}.err" || fail "${name}: $(cat "${WORK}/${name}.err")"
+}
+
+# 流水线与keep-alive：多个请求共用少数几条连接，响应体按请求的顺序写到标准输出
+start_server
+fetch pipelined -c 2 -d 4
+cmp -s "${WORK}/expected" "${WORK}/pipelined" || fail "pipelined: output differs"
+
+# 每个响应体写到目录下以请求序号命名的文件
+mkdir "${WORK}/bodies"
+fetch files -c 2 -d 4 -o "${WORK}/bodies"
+id=0
+for _ in $(seq ${REPEAT}); do
+    for path in "${PATHS[@]}"; do
+        cmp -s <("${SERVER}" --body "${path}") "${WORK}/bodies/${id}" || fail "files: body ${id} differs"
+        id=$((id + 1))
+    done
+done
+
+# 服务器每条连接只回应3个请求，且第2个响应只发送一半就断开：未完成的请求换一条连接重新发送，
+# 已经写出的那一半响应体不会重复写出
+start_server --max-requests 3 --cut-every 2
+fetch reconnect -c 2 -d 4
+cmp -s "${WORK}/expected" "${WORK}/reconnect" || fail "reconnect: output differs"
+
+# 服务器的第一个响应就带Connection: close：之后每条连接只发送一个请求
+start_server --max-requests 1
+fetch close -c 2 -d 4
+cmp -s "${WORK}/expected" "${WORK}/close" || fail "close: output differs"
+
+# 没有服务器监听的端口：非阻塞connect失败，请求重试后报告失败并以非零状态退出，程序不会一直等待
+PORT=1
+timeout 30 "${WEBGET}" -c 2 "127.0.0.1:${PORT}/bytes/10" > /dev/null 2> "${WORK}/refused.err"
+status=$?
+[ ${status} -eq 1 ] || fail "refused: webget exited with ${status}, expected 1"
+grep -q "errors=1 " "${WORK}/refused.err" || fail "refused: $(cat "${WORK}/refused.err")"
+
+echo "webget concurrent mode: all tests passed"